@@ -1,6 +1,7 @@
 #pragma once
 
 #include "FluxDecoder.h"
+#include "SyncFinder.h"
 
 class BitBuffer
 {
@@ -24,10 +25,12 @@ public:
     bool index();
     void add_index();
     void set_next_index();
+    int next_index(int bitpos) const;
 
     void sync_lost();
     void clear();
     void add(uint8_t bit);
+    void add(uint32_t bits, int num_bits);
     void remove(int num_bits);
 
     uint8_t read1();
@@ -38,6 +41,88 @@ public:
     uint32_t read32();
     uint8_t read_byte();
 
+    uint32_t peek(int num_bits) const;
+    uint32_t read_bits(int num_bits);
+
+    static uint8_t mfm_data_byte(uint32_t mfm_word);
+    static uint8_t fm_data_byte(uint32_t fm_dword);
+
+    // Shift bits into word until pred(word) is true, or max_bits have been
+    // read, or the buffer wraps. Returns true if the predicate was satisfied.
+    template <typename T, typename Pred>
+    bool shift_until(T& word, int max_bits, Pred&& pred)
+    {
+        while (max_bits > 0)
+        {
+            // Bits available without reaching the wrap point, which is left to read1().
+            auto avail = std::min(std::min(max_bits, m_bitsize - m_bitpos - 1), 32);
+            if (avail <= 0)
+            {
+                word = static_cast<T>((word << 1) | read1());
+                --max_bits;
+
+                if (pred(word))
+                    return true;
+                else if (m_wrapped)
+                    return false;
+
+                continue;
+            }
+
+            auto bits = window(m_bitpos);
+            for (auto i = 0; i < avail; ++i)
+            {
+                word = static_cast<T>((word << 1) | static_cast<T>(bits >> 63));
+                bits <<= 1;
+
+                if (pred(word))
+                {
+                    m_bitpos += i + 1;
+                    return true;
+                }
+            }
+
+            m_bitpos += avail;
+            max_bits -= avail;
+        }
+
+        return false;
+    }
+
+    // As above, but jumping between candidate offsets from find_sync(), which
+    // must include every offset at which pred(word) could be satisfied. The
+    // first bits(T) are shifted normally, to flush stale bits from word.
+    template <typename T, typename Pred>
+    bool shift_until(T& word, int max_bits, Pred&& pred, const std::vector<int>& candidates)
+    {
+        auto fresh_bits = std::min(max_bits, static_cast<int>(sizeof(T) * 8));
+        if (shift_until(word, fresh_bits, pred))
+            return true;
+        else if (m_wrapped)
+            return false;
+
+        max_bits -= fresh_bits;
+        while (max_bits > 0)
+        {
+            // Advance to the next candidate, or the wrap point if there are none.
+            auto it = std::upper_bound(candidates.begin(), candidates.end(), m_bitpos);
+            auto target = (it != candidates.end()) ? std::min(*it, m_bitsize) : m_bitsize;
+            auto step = std::min(target - m_bitpos, max_bits);
+
+            advance(word, step);
+            max_bits -= step;
+
+            if (pred(word))
+                return true;
+            else if (m_wrapped)
+                return false;
+        }
+
+        return false;
+    }
+
+    std::vector<int> find_sync(const std::vector<SyncPattern>& patterns) const;
+
     template <typename T>
     bool read(T& buf)
     {
@@ -60,6 +145,28 @@ public:
     Encoding encoding{ Encoding::MFM };
 
 private:
+    uint64_t window(int bitpos) const;
+
+    // Skip num_bits, leaving the last of them shifted into word.
+    template <typename T>
+    void advance(T& word, int num_bits)
+    {
+        constexpr int word_bits = sizeof(T) * 8;
+        if (num_bits > word_bits)
+        {
+            m_bitpos += num_bits - word_bits;
+            num_bits = word_bits;
+        }
+
+        while (num_bits > 0)
+        {
+            auto chunk = std::min(num_bits, 32);
+            auto bits = static_cast<T>(read_bits(chunk));
+            word = (chunk >= word_bits) ? bits : static_cast<T>((word << chunk) | bits);
+            num_bits -= chunk;
+        }
+    }
+
     std::vector<uint8_t> m_data{};
     std::vector<int> m_indexes{};
     std::vector<int> m_sync_losses{};
@@ -10,6 +10,7 @@ public:
     int size() const;
     void setEncoding(Encoding encoding) override;
     void addRawBit(bool bit) override;
+    void addRawBits(uint32_t bits, int num_bits) override;
     void addCrc(int size);
 
     BitBuffer& buffer();
@@ -23,7 +23,7 @@ public:
 
 private:
     static void init_crc_table();
-    static std::array<uint16_t, 256> s_crc_lookup;
+    static std::array<std::array<uint16_t, 256>, 8> s_crc_lookup;    // slice-by-8
     static std::once_flag flag;
 
     uint16_t m_crc = INIT_CRC;
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <mutex>
+
+// Standard (zlib-compatible) CRC-32. The value is kept finalised, so a
+// running CRC can be passed back in as the initial value to continue it.
+class CRC32
+{
+public:
+    static const uint32_t POLYNOMIAL = 0xedb88320;  // reflected 0x04c11db7
+
+public:
+    explicit CRC32(uint32_t init = 0);
+    CRC32(const void* buf, size_t len, uint32_t init = 0);
+    operator uint32_t () const;
+
+    void init(uint32_t crc = 0);
+    uint32_t add(const void* buf, size_t len);
+
+private:
+    static void init_crc_table();
+    static std::array<std::array<uint32_t, 256>, 8> s_crc_lookup;    // slice-by-8
+    static std::once_flag flag;
+
+    uint32_t m_crc = 0;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+// Flux revolutions held as 16-bit nanosecond intervals, which covers almost
+// every transition on a floppy. Longer gaps (and zero) are stored as a zero
+// escape word, followed by the full 32-bit value as two little-endian words.
+class CompactFlux
+{
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator() = default;
+        explicit const_iterator(const uint16_t* p) : m_p(p) {}
+
+        uint32_t operator*() const
+        {
+            return m_p[0] ? m_p[0] : (m_p[1] | (static_cast<uint32_t>(m_p[2]) << 16));
+        }
+
+        const_iterator& operator++()
+        {
+            m_p += m_p[0] ? 1 : 3;
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const { return m_p == other.m_p; }
+        bool operator!=(const const_iterator& other) const { return m_p != other.m_p; }
+
+    private:
+        const uint16_t* m_p = nullptr;
+    };
+
+    // Iteration range for a single revolution.
+    struct Revolution
+    {
+        const_iterator b, e;
+        const_iterator begin() const { return b; }
+        const_iterator end() const { return e; }
+    };
+
+    CompactFlux() = default;
+    explicit CompactFlux(const FluxData& flux_revs);
+
+    bool empty() const;
+    int size() const;
+    int flux_count() const;
+    int flux_count(int rev) const;
+
+    const_iterator begin(int rev) const;
+    const_iterator end(int rev) const;
+    Revolution operator[](int rev) const;
+    Revolution back() const;
+
+    void clear();
+    void add(const std::vector<uint32_t>& flux_times);
+    FluxData expand() const;
+
+private:
+    std::vector<uint16_t>& unshared_words();
+
+    std::shared_ptr<std::vector<uint16_t>> m_words{};  // shared by copies until changed
+    std::vector<size_t> m_rev_offsets{ 0 };     // word offset of each revolution, plus the end
+    std::vector<int> m_rev_counts{};
+};
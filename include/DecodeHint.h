@@ -0,0 +1,47 @@
+#pragma once
+
+// Encoding and data rate of the last successful decode on a disk, which are
+// tried first on the next track. Safe to share between ThreadPool workers.
+class DecodeHint
+{
+public:
+    DecodeHint() = default;
+    DecodeHint(const DecodeHint& other)
+        : m_encoding(other.encoding()), m_datarate(other.datarate())
+    {
+    }
+
+    Encoding encoding() const { return m_encoding; }
+    DataRate datarate() const { return m_datarate; }
+
+    void encoding(Encoding encoding_)
+    {
+        if (!m_frozen)
+            m_encoding = encoding_;
+    }
+
+    void datarate(DataRate datarate_)
+    {
+        if (!m_frozen)
+            m_datarate = datarate_;
+    }
+
+    // Ignore updates while frozen, so concurrent decodes see the same hint
+    // regardless of the order in which they complete.
+    class Freeze
+    {
+    public:
+        explicit Freeze(DecodeHint& hint) : m_hint(hint) { ++m_hint.m_frozen; }
+        ~Freeze() { --m_hint.m_frozen; }
+        Freeze(const Freeze&) = delete;
+        void operator= (const Freeze&) = delete;
+
+    private:
+        DecodeHint& m_hint;
+    };
+
+private:
+    std::atomic<Encoding> m_encoding{ Encoding::MFM };
+    std::atomic<DataRate> m_datarate{ DataRate::_250K };
+    std::atomic<int> m_frozen{ 0 };
+};
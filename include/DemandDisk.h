@@ -7,6 +7,7 @@ class DemandDisk : public Disk
 public:
     constexpr static int FIRST_READ_REVS = 2;
     constexpr static int REMAIN_READ_REVS = 5;
+    constexpr static int MAX_STALLED_RESCANS = 2;
 
     const TrackData& read(const CylHead& cylhead, bool uncached = false) override;
     const TrackData& write(TrackData&& trackdata) override;
@@ -18,6 +19,11 @@ protected:
     virtual bool supports_retries() const;
     virtual TrackData load(const CylHead& cylhead, bool first_read = false) = 0;
     virtual void save(TrackData& trackdata);
+    int take_spare_revs(int revs);
 
-    std::bitset<MAX_DISK_CYLS * MAX_DISK_HEADS> m_loaded{};
+    // One flag per track, each guarded by its slot lock.
+    std::array<bool, MAX_DISK_CYLS * MAX_DISK_HEADS> m_loaded{};
+
+    // Retry revolutions left unused by tracks that recovered early.
+    std::atomic<int> m_spare_revs{ 0 };
 };
@@ -5,6 +5,8 @@ const int MAX_DISK_HEADS = 2;
 
 using FluxData = std::vector<std::vector<uint32_t>>;
 
+#include "CompactFlux.h"
+
 #include "TrackData.h"
 #include "Format.h"
 
@@ -16,18 +18,19 @@ public:
 
     explicit Disk(Format& format);
 
+    virtual bool supports_concurrent_reads() const;
     virtual bool preload(const Range& range, int cyl_step);
     virtual void clear();
 
     virtual const TrackData& read(const CylHead& cylhead, bool uncached = false);
     const Track& read_track(const CylHead& cylhead, bool uncached = false);
     const BitBuffer& read_bitstream(const CylHead& cylhead, bool uncached = false);
-    const FluxData& read_flux(const CylHead& cylhead, bool uncached = false);
+    const CompactFlux& read_flux(const CylHead& cylhead, bool uncached = false);
 
     virtual const TrackData& write(TrackData&& trackdata);
     const Track& write(const CylHead& cylhead, Track&& track);
     const BitBuffer& write(const CylHead& cylhead, BitBuffer&& bitbuf);
-    const FluxData& write(const CylHead& cylhead, FluxData&& flux_revs, bool normalised = false);
+    const CompactFlux& write(const CylHead& cylhead, FluxData&& flux_revs, bool normalised = false);
 
     void each(const std::function<void(const CylHead & cylhead, const Track & track)>& func, bool cyls_first = false);
 
@@ -48,6 +51,22 @@ public:
     std::string strType = "<unknown>";
 
 protected:
-    std::map<CylHead, TrackData> m_trackdata{};
-    std::mutex m_trackdata_mutex{};
+    // Track storage indexed by CylHead, with a lock per slot so different
+    // tracks can be loaded and decoded concurrently.
+    struct TrackSlot
+    {
+        TrackData trackdata{};
+        bool present = false;
+        std::mutex mutex{};
+    };
+
+    TrackSlot& slot(const CylHead& cylhead);
+    void add_slot(const CylHead& cylhead);
+    void update_extent();
+
+    std::unique_ptr<std::array<TrackSlot, MAX_DISK_CYLS * MAX_DISK_HEADS>> m_slots{
+        std::make_unique<std::array<TrackSlot, MAX_DISK_CYLS * MAX_DISK_HEADS>>() };
+    std::atomic<int> m_cyls{ 0 };
+    std::atomic<int> m_heads{ 0 };
+    std::shared_ptr<DecodeHint> m_decode_hint{ std::make_shared<DecodeHint>() };
 };
@@ -8,7 +8,7 @@
 class FluxDecoder
 {
 public:
-    FluxDecoder(const FluxData& flux_revs, int bitcell_ns,
+    FluxDecoder(const CompactFlux& flux_revs, int bitcell_ns,
         int flux_scale_percent = 100, int pll_adjust = DEFAULT_PLL_ADJUST);
 
     bool index();
@@ -19,16 +19,23 @@ public:
     int next_bit();
     int next_flux();
 
+    // Decode all remaining flux into packed bits (lsb first), appending to
+    // data from bit offset bitsize. Index and sync loss positions are added
+    // to the event lists, as for a next_bit() loop checking them each bit.
+    void decode(std::vector<uint8_t>& data, int& bitsize,
+        std::vector<int>& indexes, std::vector<int>& sync_losses);
+
 protected:
-    const FluxData& m_flux_revs;
-    FluxData::const_iterator m_rev_it{};
-    std::vector<uint32_t>::const_iterator m_flux_it{};
+    const CompactFlux& m_flux_revs;
+    int m_rev = 0;
+    CompactFlux::const_iterator m_flux_it{}, m_flux_end{};
 
     int m_clock = 0, m_clock_centre, m_clock_min, m_clock_max;
     int m_flux = 0;
     int m_clocked_zeros = 0;
     int m_flux_scale_percent = 100;
     int m_pll_adjust = 0;
+    int m_pll_phase = DEFAULT_PLL_PHASE;
     int m_goodbits = 0;
     bool m_index = false;
     bool m_sync_lost = false;
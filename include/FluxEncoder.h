@@ -0,0 +1,46 @@
+#pragma once
+
+#define DEFAULT_PRECOMP_CYL 40
+#define DEFAULT_PRECOMP_NS  240
+#define MAX_PRECOMP_NS      1000
+
+// Write precompensation for tracks from a given cylinder, optionally limited
+// to one data rate. A transition is moved away from a closer neighbour, to
+// allow for attraction between them when written.
+struct PrecompZone
+{
+    int cyl = 0;
+    DataRate datarate = DataRate::Unknown;
+    int early_ns = 0;   // shift when the neighbour follows
+    int late_ns = 0;    // shift when the neighbour precedes
+};
+
+std::vector<PrecompZone> precomp_from_string(const std::string& str);
+
+class FluxEncoder
+{
+public:
+    FluxEncoder(const CylHead& cylhead, DataRate datarate, uint32_t start_time = 0);
+
+    // Add up to MAX_ADD_BITS bitcells, with the first in the lsb.
+    void add(uint64_t bits, int num_bits);
+
+    // Add bitcells from packed data (lsb first), starting at bit offset bitpos.
+    void add(const std::vector<uint8_t>& data, int bitpos, int num_bits);
+
+    // Complete any time since the last transition with a final transition.
+    void flush();
+
+    std::vector<uint32_t>& flux_times();
+
+    static const int MAX_ADD_BITS{ 62 };
+
+private:
+    std::vector<uint32_t> m_flux_times{};
+    uint32_t m_bitcell_ns{ 0 };
+    uint32_t m_flux_time{ 0 };
+    int m_early_ns{ 0 };
+    int m_late_ns{ 0 };
+    bool m_last_bit{ false };
+    bool m_curr_bit{ false };
+};
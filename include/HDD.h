@@ -3,6 +3,7 @@
 class MEMORY;
 
 const int SECTOR_SIZE = 512;
+const int MAX_BLOCK_SIZE_KB = 64 * 1024;   // largest --block-size for HDD copies
 
 struct IDENTIFYDEVICE
 {
@@ -1,5 +1,35 @@
 #pragma once
 
+// Incremental KryoFlux stream decoder, accepting data in chunks of any size
+// as it arrives. Each revolution is available once its closing index is seen.
+class KFStreamDecoder
+{
+public:
+    KFStreamDecoder();
+
+    void add(const uint8_t* data, int len);
+    bool next_rev(std::vector<uint32_t>& flux_times);
+    bool eof() const;
+    FluxData finish(std::vector<std::string>& warnings);
+
+private:
+    int decode_block(const uint8_t* p, int len);
+    void end_revs(bool at_end);
+
+    Data m_pending{};
+    std::vector<uint32_t> m_flux_times{};
+    std::vector<uint32_t> m_flux_counts{};
+    std::deque<uint32_t> m_index_offsets{};
+    std::deque<std::vector<uint32_t>> m_revs{};
+    std::vector<std::string> m_warnings{};
+    uint32_t m_time = 0;
+    uint32_t m_stream_pos = 0;
+    uint32_t m_ps_per_tick = 0;
+    uint32_t m_last_pos = 0;
+    int m_hard_indexes = 0;
+    bool m_eof = false;
+};
+
 class KryoFlux
 {
 public:
@@ -29,8 +59,9 @@ public:
     int SetMaxTrack(int cyl);
     int GetInfo(int index, std::string& info);
 
-    void ReadFlux(int indexes, FluxData& flux_revs, std::vector<std::string>& warnings);
-    static FluxData DecodeStream(const Data& data, std::vector<std::string>& warnings);
+    void ReadFlux(int indexes, const std::function<void(std::vector<uint32_t>&& flux_times)>& on_rev,
+        std::vector<std::string>& warnings);
+    static FluxData DecodeStream(const uint8_t* pb, int len, std::vector<std::string>& warnings);
 
 private:
     static const int REQ_STATUS = 0x00;                 // status
@@ -12,6 +12,7 @@ public:
         const std::string& filename = "");
 
     const Data& data() const;
+    const uint8_t* bytes() const;
     int size() const;
     int remaining() const;
     const std::string& path() const;
@@ -32,16 +33,15 @@ public:
         if (remaining() < total_size)
             return false;
 
-        std::memcpy(buf.data(), &*m_it, total_size);
-        //  std::copy(m_it, m_it + size, buf.data());
-        m_it += total_size;
+        std::memcpy(buf.data(), m_pb + m_pos, total_size);
+        m_pos += total_size;
         return true;
     }
 
     template <typename T>
     auto ptr() const
     {
-        return reinterpret_cast<const T*>(&*m_it);
+        return reinterpret_cast<const T*>(m_pb + m_pos);
     }
 
     bool rewind();
@@ -50,9 +50,18 @@ public:
     bool eof() const;
 
 private:
+    bool open_mapped(const std::string& path);
+    void open_read(const std::string& path);
+    void decompress(const std::string& path, std::string& filename);
+    void set_path(const std::string& path, const std::string& filename);
+
     std::string m_path{};
     std::string m_filename{};
-    Data m_data{};
-    Data::iterator m_it{};
+    // Contents are shared between copies, which makes them cheap to keep.
+    mutable std::shared_ptr<Data> m_data{};         // decompressed content, or a copy for data()
+    std::shared_ptr<const uint8_t> m_mapping{};     // read-only view of an uncompressed file
+    const uint8_t* m_pb = nullptr;                  // contents, in m_data or m_mapping
+    int m_size = 0;
+    int m_pos = 0;
     Compress m_compress = Compress::None;
 };
@@ -56,6 +56,8 @@ typedef void* HANDLE;
 #include <iomanip>
 #include <array>
 #include <vector>
+#include <deque>
+#include <queue>
 #include <map>
 #include <set>
 #include <memory>    // for unique_ptr
@@ -79,6 +81,9 @@ typedef void* HANDLE;
 #include <fcntl.h>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <cassert>
 #include <system_error>
 
@@ -176,9 +181,11 @@ typedef void* HANDLE;
 #include "utils.h"
 #include "win32_error.h"
 #include "CRC16.h"
+#include "CRC32.h"
 #include "Disk.h"
 #include "DiskUtil.h"
 #include "Header.h"
+#include "FluxEncoder.h"
 #include "MemFile.h"
 #include "Image.h"
 #include "HDD.h"
@@ -197,6 +204,9 @@ bool Hdd2Boot(const std::string& hdd_path, const std::string& boot_path);
 bool Boot2Hdd(const std::string& boot_path, const std::string& hdd_path);
 bool Boot2Boot(const std::string& src_path, const std::string& dst_path);
 
+// batch
+bool BatchConvert(const std::string& src_spec, const std::string& dst_pattern);
+
 // create
 bool CreateImage(const std::string& path, Range range);
 bool CreateHddImage(const std::string& path, int nSizeMB_);
@@ -248,7 +258,8 @@ struct OPTIONS
     int base = -1, size = -1, gap3 = -1, interleave = -1, skew = -1, fill = -1;
     int gaps = -1, gap2 = -1, gap4b = -1, idcrc = -1, gapmask = -1, maxsplice = -1;
     int cylsfirst = -1, head0 = -1, head1 = -1, steprate = -1, check8k = -1;
-    int offsets = -1, fix = -1, mt = -1, plladjust = -1, hardsectors = -1;
+    int offsets = -1, fix = -1, mt = -1, plladjust = -1, hardsectors = -1, complevel = -1;
+    int blocksize = -1;
 
     int command = 0, hex = 0, debug = 0, verbose = 0, log = 0, force = 0, quick = 0;
     int merge = 0, repair = 0, trim = 0, calibrate = 0, newdrive = 0, byteswap = 0;
@@ -257,7 +268,7 @@ struct OPTIONS
     int bdos = 0, atom = 0, hdf = 0, resize = 0, cpm = 0, minimal = 0, legacy = 0;
     int absoffsets = 0, datacopy = 0, align = 0, keepoverlap = 0, fmoverlap = 0;
     int rescans = 0, flip = 0, multiformat = 0, rpm = 0, tty = 0, time = 0;
-    int a1sync = 0;
+    int a1sync = 0, direct = 0;
 
     int retries = 5, maxcopies = 3;
     int scale = 100, pllphase = DEFAULT_PLL_PHASE;
@@ -266,6 +277,7 @@ struct OPTIONS
     Encoding encoding{ Encoding::Unknown };
     DataRate datarate{ DataRate::Unknown };
     PreferredData prefer = PreferredData::Unknown;
+    std::vector<PrecompZone> precomp{ { DEFAULT_PRECOMP_CYL, DataRate::Unknown, DEFAULT_PRECOMP_NS, DEFAULT_PRECOMP_NS } };
     long sectors = -1;
     std::string label{}, boot{};
 
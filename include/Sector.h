@@ -63,8 +63,10 @@ public:
     uint8_t dam = 0xfb;                     // data address mark
 
 private:
+    DataList& unshared_datas();
+
     bool m_bad_id_crc = false;
     bool m_bad_data_crc = false;
-    std::vector<Data> m_data{};         // copies of sector data
+    std::shared_ptr<DataList> m_data{}; // copies of sector data, shared until changed
 };
 #pragma once
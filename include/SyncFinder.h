@@ -0,0 +1,17 @@
+#pragma once
+
+// Masked 32-bit sync pattern, with the first bit read in the msb.
+// Shorter patterns clear the unused upper bits of the mask.
+struct SyncPattern
+{
+    uint32_t value = 0;
+    uint32_t mask = 0xffffffff;
+
+    bool matches(uint32_t dword) const { return (dword & mask) == value; }
+};
+
+// Find every bit alignment at which one of the patterns occurs in a packed
+// (lsb first) bitstream. Returns the sorted bit offsets just beyond each
+// match, which are the stream positions at which a bit-by-bit shift
+// register would see the pattern.
+std::vector<int> find_sync(const uint8_t* data, int bitsize, const std::vector<SyncPattern>& patterns);
@@ -19,7 +19,19 @@ public:
         return threads ? static_cast<int>(threads) : 1;
     }
 
+    // True on a pool worker, where work shouldn't be spread over more threads.
+    static bool is_worker_thread()
+    {
+        return worker_thread();
+    }
+
 private:
+    static bool& worker_thread()
+    {
+        thread_local bool worker = false;
+        return worker;
+    }
+
     bool _stop;
     std::mutex _mutex{};
     std::condition_variable _cond{};
@@ -37,6 +49,8 @@ inline ThreadPool::ThreadPool(int threads)
     for (auto i = 0; i < threads; ++i)
     {
         _threads.emplace_back([this]() {
+            worker_thread() = true;
+
             for (;;)
             {
                 std::function<void()> task;
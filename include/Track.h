@@ -38,9 +38,9 @@ public:
     Track& format(const CylHead& cylhead, const Format& format);
     Data::const_iterator populate(Data::const_iterator it, Data::const_iterator itEnd);
 
-    std::vector<Sector>::reverse_iterator rbegin() { return m_sectors.rbegin(); }
-    std::vector<Sector>::iterator begin() { return m_sectors.begin(); }
-    std::vector<Sector>::iterator end() { return m_sectors.end(); }
+    std::vector<Sector>::reverse_iterator rbegin() { m_order = Order::Unknown; return m_sectors.rbegin(); }
+    std::vector<Sector>::iterator begin() { m_order = Order::Unknown; return m_sectors.begin(); }
+    std::vector<Sector>::iterator end() { m_order = Order::Unknown; return m_sectors.end(); }
     std::vector<Sector>::iterator find(const Sector& sector);
     std::vector<Sector>::iterator find(const Header& header);
     std::vector<Sector>::iterator find(const Header& header, const DataRate datarate, const Encoding encoding);
@@ -56,7 +56,13 @@ public:
     int tracktime = 0;  // track time in us
 
 private:
+    enum class Order { Unknown, Ordered, Unordered };
+
+    bool is_ordered();
+    std::vector<Sector>::iterator find_nearby(const Sector& sector);
+
     std::vector<Sector> m_sectors{};
+    Order m_order = Order::Ordered;     // whether sectors are in offset order
 
     // Max bitstream position difference for sectors to be considerd the same.
     // Used to match sectors between revolutions, and needs to cope with the
@@ -10,6 +10,7 @@ public:
 
     virtual void setEncoding(Encoding encoding);
     virtual void addRawBit(bool one) = 0;
+    virtual void addRawBits(uint32_t bits, int num_bits);
 
     void addBit(bool bit);
     void addDataBit(bool bit);
@@ -2,6 +2,7 @@
 
 #include "Track.h"
 #include "BitBuffer.h"
+#include "DecodeHint.h"
 
 class TrackData
 {
@@ -14,6 +15,7 @@ public:
     TrackData(const CylHead& cylhead_, Track&& track);
     TrackData(const CylHead& cylhead_, BitBuffer&& bitstream);
     TrackData(const CylHead& cylhead_, FluxData&& flux, bool normalised = false);
+    TrackData(const CylHead& cylhead_, CompactFlux&& flux, bool normalised = false);
 
     auto type() const { return m_type; }
     bool has_track() const;
@@ -23,15 +25,17 @@ public:
 
     const Track& track();
     /*const*/ BitBuffer& bitstream();
-    const FluxData& flux();
+    const CompactFlux& flux();
     TrackData preferred();
 
     void add(TrackData&& trackdata);
     void add(Track&& track);
     void add(BitBuffer&& bitstream);
     void add(FluxData&& flux, bool normalised = false);
+    void add(CompactFlux&& flux, bool normalised = false);
 
     CylHead cylhead{};
+    std::shared_ptr<DecodeHint> hint{};     // shared by the tracks of a disk
 
 private:
     TrackDataType m_type{ TrackDataType::None };
@@ -39,6 +43,6 @@ private:
 
     Track m_track{};
     BitBuffer m_bitstream{};
-    FluxData m_flux{};
+    CompactFlux m_flux{};
     bool m_normalised_flux = false;
 };
@@ -106,7 +106,22 @@ const char* CHS(int cyl, int head, int sector);
 const char* CHR(int cyl, int head, int record);
 const char* CHSR(int cyl, int head, int sector, int record);
 
+struct MessageCounts
+{
+    int info = 0;
+    int fixes = 0;
+    int warnings = 0;
+};
+
 extern std::set<std::string> seen_messages;
+extern std::mutex message_mutex;
+extern MessageCounts* message_counts;
+
+// Messages from a worker thread can be held back, so the thread that uses
+// its results can show them in order.
+using DeferredMessages = std::vector<std::pair<MsgType, std::string>>;
+extern thread_local DeferredMessages* deferred_messages;
+void ShowDeferredMessages(const DeferredMessages& messages);
 
 template <typename ...Args>
 void Message(MsgType type, const char* pcsz_, Args&& ...args)
@@ -116,12 +131,32 @@ void Message(MsgType type, const char* pcsz_, Args&& ...args)
     if (type == msgError)
         throw util::exception(msg);
 
+    // Status from a deferring worker would be out of date when shown.
+    if (deferred_messages)
+    {
+        if (type != msgStatus)
+            deferred_messages->emplace_back(type, std::move(msg));
+        return;
+    }
+
+    // Messages may come from worker threads decoding tracks.
+    std::lock_guard<std::mutex> lock(message_mutex);
+
     if (type != msgStatus)
     {
         if (seen_messages.find(msg) != seen_messages.end())
             return;
 
         seen_messages.insert(msg);
+
+        // Batch conversions tally messages rather than showing them.
+        if (message_counts)
+        {
+            message_counts->info += (type == msgInfo);
+            message_counts->fixes += (type == msgFix);
+            message_counts->warnings += (type == msgWarning);
+            return;
+        }
     }
 
     switch (type)
@@ -155,6 +190,7 @@ bool CheckLibrary(const char* pcszLib_, const char* pcszFunc_);
 
 bool IsFile(const std::string& path);
 bool IsDir(const std::string& path);
+std::vector<std::string> ListDir(const std::string& path);
 bool IsFloppy(const std::string& path);
 bool IsHddImage(const std::string& path);
 bool IsBootSector(const std::string& path);
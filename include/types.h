@@ -12,6 +12,15 @@ struct IMAGE_ENTRY
     IMAGE_WRITEFUNC pfnWrite;
 };
 
+// Bytes an image must hold at the given offset for its reader to accept it.
+struct IMAGE_SIGNATURE
+{
+    IMAGE_READFUNC pfnRead;
+    size_t offset;
+    const char* pszSignature;
+    size_t len;
+};
+
 struct DEVICE_ENTRY
 {
     const char* pszType;
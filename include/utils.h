@@ -91,6 +91,15 @@ std::string make_string(Args&& ... args)
 
 void bit_reverse(uint8_t* pb, int len);
 
+inline uint32_t reverse_bits32(uint32_t x)
+{
+    x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+    x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+    x = ((x >> 4) & 0x0f0f0f0f) | ((x & 0x0f0f0f0f) << 4);
+    x = ((x >> 8) & 0x00ff00ff) | ((x & 0x00ff00ff) << 8);
+    return (x >> 16) | (x << 16);
+}
+
 template <typename T> T byteswap(T x);
 
 template<>
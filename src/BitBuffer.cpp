@@ -27,22 +27,13 @@ BitBuffer::BitBuffer(DataRate datarate_, FluxDecoder& decoder)
     auto bitlen{ bits_per_second(datarate) * decoder.flux_revs() * 60 / 300 * 2 * 120 / 100 };
     m_data.resize((bitlen + 7) / 8);
 
-    for (;;)
-    {
-        auto bit{ decoder.next_bit() };
-        if (bit < 0)
-            break;
-
-        if (decoder.sync_lost())
-        {
-            if (opt.debug) util::cout << "sync lost at offset " << tell() << " (" << track_offset(tell()) << ")\n";
-            sync_lost();
-        }
-
-        add(bit ? 1 : 0);
+    decoder.decode(m_data, m_bitsize, m_indexes, m_sync_losses);
+    m_bitpos = m_bitsize;
 
-        if (decoder.index())
-            add_index();
+    if (opt.debug)
+    {
+        for (auto pos : m_sync_losses)
+            util::cout << "sync lost at offset " << pos << " (" << track_offset(pos) << ")\n";
     }
 }
 
@@ -104,17 +95,20 @@ void BitBuffer::add_index()
 }
 
 void BitBuffer::set_next_index()
+{
+    m_next_index = next_index(m_bitpos);
+}
+
+// The first index after bitpos, or the buffer size if there isn't one.
+int BitBuffer::next_index(int bitpos) const
 {
     for (auto& index : m_indexes)
     {
-        if (index > m_bitpos)
-        {
-            m_next_index = index;
-            return;
-        }
+        if (index > bitpos)
+            return index;
     }
 
-    m_next_index = m_bitsize;
+    return m_bitsize;
 }
 
 void BitBuffer::sync_lost()
@@ -148,6 +142,37 @@ void BitBuffer::add(uint8_t bit)
     m_bitsize = std::max(m_bitsize, ++m_bitpos);
 }
 
+// Add up to 32 bits, most significant first.
+void BitBuffer::add(uint32_t bits, int num_bits)
+{
+    assert(num_bits >= 0 && num_bits <= 32);
+    if (num_bits <= 0)
+        return;
+
+    size_t end_offset = (m_bitpos + num_bits - 1) / 8;
+
+    // Double the size if we run out of space
+    while (end_offset >= m_data.size())
+    {
+        assert(m_data.size() != 0);
+        m_data.resize(m_data.size() * 2);
+        if (opt.debug) util::cout << "BitBuffer size grown to " << m_data.size() << "\n";
+    }
+
+    // Reverse the bits, as the buffer holds the first bit in the lowest bit.
+    bits = util::reverse_bits32(bits);
+
+    auto shift = m_bitpos & 7;
+    auto value = static_cast<uint64_t>(bits >> (32 - num_bits)) << shift;
+    auto mask = ((uint64_t(1) << num_bits) - 1) << shift;
+
+    for (auto offset = static_cast<size_t>(m_bitpos / 8); mask; ++offset, value >>= 8, mask >>= 8)
+        m_data[offset] = static_cast<uint8_t>((m_data[offset] & ~mask) | (value & mask));
+
+    m_bitpos += num_bits;
+    m_bitsize = std::max(m_bitsize, m_bitpos);
+}
+
 void BitBuffer::remove(int num_bits)
 {
     assert(m_bitpos >= num_bits);
@@ -170,17 +195,12 @@ uint8_t BitBuffer::read1()
 
 uint8_t BitBuffer::read2()
 {
-    return (read1() << 1) | read1();
+    return static_cast<uint8_t>(read_bits(2));
 }
 
 uint8_t BitBuffer::read8_msb()
 {
-    uint8_t byte = 0;
-
-    for (auto i = 0; i < 8; ++i)
-        byte = (byte << 1) | read1();
-
-    return byte;
+    return static_cast<uint8_t>(read_bits(8));
 }
 
 uint8_t BitBuffer::read8_lsb()
@@ -195,22 +215,107 @@ uint8_t BitBuffer::read8_lsb()
 
 uint16_t BitBuffer::read16()
 {
-    uint16_t word = 0;
+    return static_cast<uint16_t>(read_bits(16));
+}
 
-    for (auto i = 0; i < 16; ++i)
-        word = (word << 1) | read1();
+uint32_t BitBuffer::read32()
+{
+    return read_bits(32);
+}
 
-    return word;
+// Bits are stored lsb first in each byte, so reverse them for msb first reads.
+static const std::array<uint8_t, 256> bit_reverse = [] {
+    std::array<uint8_t, 256> table{};
+    for (auto i = 0; i < 256; ++i)
+    {
+        for (auto j = 0; j < 8; ++j)
+            table[i] |= ((i >> j) & 1) << (7 - j);
+    }
+    return table;
+}();
+
+// Return at least 57 bits from the given offset, with the first bit in the msb.
+uint64_t BitBuffer::window(int bitpos) const
+{
+    size_t offset = bitpos / 8;
+    uint64_t bits = 0;
+
+    if (offset + 8 <= m_data.size())
+    {
+        auto p = m_data.data() + offset;
+        for (auto i = 0; i < 8; ++i)
+            bits = (bits << 8) | bit_reverse[p[i]];
+    }
+    else
+    {
+        for (auto i = 0; i < 8; ++i, ++offset)
+            bits = (bits << 8) | ((offset < m_data.size()) ? bit_reverse[m_data[offset]] : 0);
+    }
+
+    return bits << (bitpos & 7);
 }
 
-uint32_t BitBuffer::read32()
+uint32_t BitBuffer::peek(int num_bits) const
 {
-    uint32_t dword = 0;
+    assert(num_bits > 0 && num_bits <= 32);
+
+    if (m_bitpos + num_bits <= m_bitsize)
+        return static_cast<uint32_t>(window(m_bitpos) >> (64 - num_bits));
+
+    // Slow path for bits that wrap back to the start of the buffer.
+    uint32_t bits = 0;
+    for (auto i = 0, pos = m_bitpos; i < num_bits; ++i)
+    {
+        bits = (bits << 1) | ((m_data[pos / 8] >> (pos & 7)) & 1);
+        if (++pos == m_bitsize)
+            pos = 0;
+    }
+
+    return bits;
+}
 
-    for (auto i = 0; i < 32; ++i)
-        dword = (dword << 1) | read1();
+uint32_t BitBuffer::read_bits(int num_bits)
+{
+    assert(num_bits > 0 && num_bits <= 32);
+
+    if (m_bitpos + num_bits > m_bitsize)
+    {
+        uint32_t bits = 0;
+        for (auto i = 0; i < num_bits; ++i)
+            bits = (bits << 1) | read1();
+        return bits;
+    }
+
+    auto bits = static_cast<uint32_t>(window(m_bitpos) >> (64 - num_bits));
+
+    if ((m_bitpos += num_bits) == m_bitsize)
+    {
+        m_bitpos = 0;
+        m_wrapped = true;
+    }
+
+    return bits;
+}
+
+// Extract the 8 data bits from a 16-bit MFM clock/data word.
+uint8_t BitBuffer::mfm_data_byte(uint32_t mfm_word)
+{
+    // Compact the even bit positions, PEXT-style.
+    auto x = mfm_word & 0x5555;
+    x = (x | (x >> 1)) & 0x3333;
+    x = (x | (x >> 2)) & 0x0f0f;
+    x = (x | (x >> 4)) & 0x00ff;
+    return static_cast<uint8_t>(x);
+}
 
-    return dword;
+// Extract the 8 data bits from a 32-bit FM word, with data in bit 1 of each nibble.
+uint8_t BitBuffer::fm_data_byte(uint32_t fm_dword)
+{
+    auto x = (fm_dword >> 1) & 0x11111111;
+    x = (x | (x >> 3)) & 0x03030303;
+    x = (x | (x >> 6)) & 0x000f000f;
+    x = (x | (x >> 12)) & 0x000000ff;
+    return static_cast<uint8_t>(x);
 }
 
 const uint8_t gcr5char[32] = {
@@ -228,28 +333,15 @@ uint8_t BitBuffer::read_byte()
     switch (encoding)
     {
     case Encoding::FM:
-        for (auto i = 0; i < 8; ++i)
-        {
-            read1();
-            read1();
-            data = (data << 1) | read1();
-            read1();
-        }
+        data = fm_data_byte(read_bits(32));
         break;
 
     case Encoding::MFM:
-        for (auto i = 0; i < 8; ++i)
-        {
-            read1();
-            data = (data << 1) | read1();
-        }
+        data = mfm_data_byte(read_bits(16));
         break;
 
     case Encoding::Apple:
-        for (auto i = 0; i < 8; ++i)
-        {
-            data = (data << 1) | read1();
-        }
+        data = static_cast<uint8_t>(read_bits(8));
         // Disk ][ keeps reading until bit 7 is 1
         for (; (data & 0x80) == 0;)
         {
@@ -259,18 +351,12 @@ uint8_t BitBuffer::read_byte()
 
     case Encoding::GCR:
     case Encoding::Victor:
-        for (auto i = 0; i < 10; ++i)
-        {
-            gcr = (gcr << 1) | read1();
-        }
+        gcr = static_cast<uint16_t>(read_bits(10));
         data = (gcr5char[gcr >> 5] << 4) | gcr5char[gcr & 0x1f];
         break;
 
     default:
-        for (auto i = 0; i < 8; ++i)
-        {
-            data = (data << 1) | read1();
-        }
+        data = static_cast<uint8_t>(read_bits(8));
         break;
     }
 
@@ -293,6 +379,11 @@ int BitBuffer::track_offset(int bitpos) const
     return bitpos;
 }
 
+std::vector<int> BitBuffer::find_sync(const std::vector<SyncPattern>& patterns) const
+{
+    return ::find_sync(m_data.data(), m_bitsize, patterns);
+}
+
 BitBuffer BitBuffer::track_bitstream() const
 {
     BitBuffer newbuf(datarate, encoding);
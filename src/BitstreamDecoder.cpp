@@ -8,17 +8,115 @@
 #include "IBMPC.h"
 #include "JupiterAce.h"
 #include "SpecialFormat.h"
+#include "ThreadPool.h"
 
 static const int JITTER_PERCENT = 2;
 
+// Encoding family and data rate suggested by the flux interval histogram.
+struct FluxProfile
+{
+    Encoding encoding{ Encoding::Unknown };     // MFM, FM, GCR or Unknown
+    DataRate datarate{ DataRate::Unknown };
+};
+
+// Build a histogram of flux intervals on the last revolution, and from the
+// relative positions of its peaks guess the encoding family and bitcell.
+// MFM gives peaks at 2T/3T(/4T), FM at 2T/4T, and GCR at 1T/2T/3T.
+static FluxProfile profile_flux(const CompactFlux& flux_revs)
+{
+    constexpr int BIN_NS = 50;
+    constexpr int MAX_BINS = 20000 / BIN_NS;
+    constexpr int MIN_TRANSITIONS = 1000;
+
+    FluxProfile profile;
+    std::array<int, MAX_BINS> bins{};
+    auto total = 0;
+
+    for (auto time_ns : flux_revs.back())
+    {
+        auto bin = static_cast<int64_t>(time_ns) * opt.scale / 100 / BIN_NS;
+        if (bin < MAX_BINS)
+        {
+            ++bins[static_cast<size_t>(bin)];
+            ++total;
+        }
+    }
+
+    if (total < MIN_TRANSITIONS)
+        return profile;
+
+    // Group runs of well populated bins into peaks, ignoring sparse noise
+    // between them and any peak holding under 2% of the transitions.
+    std::vector<int> peaks;
+    auto threshold = total / 500;
+    int64_t sum = 0;
+    auto count = 0;
+
+    for (auto i = 0; i <= MAX_BINS; ++i)
+    {
+        if (i < MAX_BINS && bins[i] > threshold)
+        {
+            sum += static_cast<int64_t>(bins[i]) * (i * BIN_NS + BIN_NS / 2);
+            count += bins[i];
+        }
+        else if (count)
+        {
+            if (count >= total / 50)
+                peaks.push_back(static_cast<int>(sum / count));
+
+            sum = count = 0;
+        }
+    }
+
+    if (peaks.empty())
+        return profile;
+
+    auto shortest = peaks[0];
+    auto has_peak = [&](int num, int den) {
+        return std::any_of(peaks.begin(), peaks.end(), [&](int peak) {
+            return std::abs(peak * den - shortest * num) * 100 < shortest * num * 15;
+            });
+    };
+
+    if (has_peak(3, 2))
+        profile.encoding = Encoding::MFM;
+    else if (has_peak(2, 1) && has_peak(3, 1))
+        profile.encoding = Encoding::GCR;
+    else if (has_peak(2, 1))
+        profile.encoding = Encoding::FM;
+
+    // The GCR scanners use their own zoned bitcell widths.
+    if (profile.encoding == Encoding::MFM || profile.encoding == Encoding::FM)
+    {
+        // The 250K and 300K windows overlap, so take the closest rate.
+        auto bitcell = shortest / 2;
+        auto best_error = 15.0;
+        for (auto datarate : { DataRate::_250K, DataRate::_300K, DataRate::_500K, DataRate::_1M })
+        {
+            auto error = std::abs(bitcell - bitcell_ns(datarate)) * 100.0 / bitcell_ns(datarate);
+            if (error < best_error)
+            {
+                profile.datarate = datarate;
+                best_error = error;
+            }
+        }
+    }
+
+    return profile;
+}
+
 // Scan track flux reversals for sectors. We default to the order MFM/FM,
-// Amiga, then GCR. On subsequent calls the last successful encoding is
-// checked first, as it's the most likely.
+// Amiga, then GCR. The last successful encoding on the same disk is taken
+// from the decode hint and checked first, as it's the most likely. A flux
+// histogram pre-pass can promote a different encoding family and data rate
+// ahead of those.
 
 void scan_flux(TrackData& trackdata)
 {
-    static DataRate last_datarate = DataRate::_250K;
-    static Encoding last_encoding = Encoding::MFM;
+    DecodeHint default_hint;
+    auto& hint = trackdata.hint ? *trackdata.hint : default_hint;
+    auto last_datarate = hint.datarate();
+    auto last_encoding = hint.encoding();
 
     // Return an empty track if we have no data
     if (trackdata.flux().empty())
@@ -52,6 +150,34 @@ void scan_flux(TrackData& trackdata)
             encodings.erase(std::find(encodings.rbegin(), encodings.rend(), Encoding::MFM).base());
     }
 
+    auto profile = profile_flux(trackdata.flux());
+    if (opt.debug && profile.encoding != Encoding::Unknown)
+        util::cout << "flux histogram suggests " << profile.encoding << " at " << profile.datarate << "\n";
+
+    // Try the suggested encoding family first, keeping the order within it.
+    if (opt.encoding == Encoding::Unknown && profile.encoding != Encoding::Unknown)
+    {
+        std::stable_partition(encodings.begin(), encodings.end(), [&](Encoding encoding) {
+            switch (encoding)
+            {
+            case Encoding::MFM:
+            case Encoding::FM:
+                return profile.encoding != Encoding::GCR;
+            case Encoding::Amiga:
+                return profile.encoding == Encoding::MFM;
+            case Encoding::GCR:
+            case Encoding::Apple:
+            case Encoding::Victor:
+                return profile.encoding == Encoding::GCR;
+            default:
+                return false;
+            }
+            });
+    }
+
+    // Start with the suggested data rate, falling back to the last successful one.
+    auto datarate = (profile.datarate != DataRate::Unknown) ? profile.datarate : last_datarate;
+
     for (auto encoding : encodings)
     {
         switch (encoding)
@@ -59,7 +185,7 @@ void scan_flux(TrackData& trackdata)
         case Encoding::MFM:
         case Encoding::FM:
         case Encoding::RX02:
-            scan_flux_mfm_fm(trackdata, last_datarate);
+            scan_flux_mfm_fm(trackdata, datarate);
             break;
 
         case Encoding::Amiga:
@@ -79,11 +205,11 @@ void scan_flux(TrackData& trackdata)
             break;
 
         case Encoding::MX:
-            scan_flux_mx(trackdata, last_datarate);
+            scan_flux_mx(trackdata, datarate);
             break;
 
         case Encoding::Agat:
-            scan_flux_agat(trackdata, last_datarate);
+            scan_flux_agat(trackdata, datarate);
             break;
 
         case Encoding::Victor:
@@ -103,13 +229,13 @@ void scan_flux(TrackData& trackdata)
         if (!trackdata.track().empty())
         {
             // Remember the successful data rate for next time.
-            last_datarate = trackdata.track()[0].datarate;
+            hint.datarate(trackdata.track()[0].datarate);
 
             // If we're not scanning multiple formats, store the match and finish.
             if (!opt.multiformat)
             {
                 // Remember the encoding so we try it first next time
-                last_encoding = encoding;
+                hint.encoding(encoding);
                 break;
             }
         }
@@ -120,7 +246,9 @@ void scan_flux(TrackData& trackdata)
 // Scan a track bitstream for sectors
 void scan_bitstream(TrackData& trackdata)
 {
-    static Encoding last_encoding = Encoding::MFM;
+    DecodeHint default_hint;
+    auto& hint = trackdata.hint ? *trackdata.hint : default_hint;
+    auto last_encoding = hint.encoding();
 
     std::vector<Encoding> encodings;
     if (opt.encoding != Encoding::Unknown)
@@ -192,7 +320,7 @@ void scan_bitstream(TrackData& trackdata)
         if (!trackdata.track().empty() && !opt.multiformat)
         {
             // Remember the encoding so we try it first next time
-            last_encoding = encoding;
+            hint.encoding(encoding);
             break;
         }
     }
@@ -727,7 +855,7 @@ void scan_bitstream_ace(TrackData& trackdata)
     while (!bitbuf.wrapped())
     {
         // Read the next clock and data bits
-        word = (bitbuf.read1() << 1) | bitbuf.read1();
+        word = bitbuf.read2();
 
         // If the clock is missing, attempt to re-sync by skipping a bit
         if (!(word & 2))
@@ -759,7 +887,7 @@ void scan_bitstream_ace(TrackData& trackdata)
         for (int i = 0; i < 10; ++i)
         {
             // Fetch clock and data bits
-            word = (bitbuf.read1() << 1) | bitbuf.read1();
+            word = bitbuf.read2();
 
             // Extract bit, update parity and clock status
             bit = ~word & 1;
@@ -884,6 +1012,7 @@ void scan_bitstream_mx(TrackData& trackdata)
     bitbuf.encoding = Encoding::FM;
     track.tracklen = bitbuf.track_bitsize();
     bool sync = false;
+    auto candidates = bitbuf.find_sync({ { 0xaaaa88aa } });
 
     while (!bitbuf.wrapped())
     {
@@ -895,7 +1024,9 @@ void scan_bitstream_mx(TrackData& trackdata)
         if (sync)
             break;
 
-        dword = (dword << 1) | bitbuf.read1();
+        auto max_bits = track.size() ? std::numeric_limits<int>::max() : (track.tracklen - bitbuf.tell() + 1);
+        if (!bitbuf.shift_until(dword, max_bits, [](uint64_t dw) { return dw == 0x88888888aaaa88aa; }, candidates))
+            continue;
 
         switch (dword)
         {
@@ -1027,6 +1158,8 @@ void scan_bitstream_amiga(TrackData& trackdata)
     CRC16 crc;
     uint32_t dword = 0;
     uint32_t sync_mask = opt.a1sync ? 0xffdfffdf : 0xffffffff;
+    SyncPattern sync{ 0x44894489 & sync_mask, sync_mask };
+    auto candidates = bitbuf.find_sync({ sync });
 
     while (!bitbuf.wrapped())
     {
@@ -1034,10 +1167,9 @@ void scan_bitstream_amiga(TrackData& trackdata)
         if (!track.size() && bitbuf.tell() > track.tracklen)
             break;
 
-        dword = (dword << 1) | bitbuf.read1();
-
         // Check for A1A1 MFM sync markers
-        if ((dword & sync_mask) != 0x44894489)
+        auto max_bits = track.size() ? std::numeric_limits<int>::max() : (track.tracklen - bitbuf.tell() + 1);
+        if (!bitbuf.shift_until(dword, max_bits, [&](uint32_t dw) { return sync.matches(dw); }, candidates))
             continue;
 
         auto sector_offset = bitbuf.tell();
@@ -1133,13 +1265,28 @@ void scan_bitstream_mfm_fm(TrackData& trackdata)
     uint32_t dword = 0;
     uint8_t last_fm_am = 0;
 
+    // MFM sync and FM address marks, checked further below.
+    std::vector<SyncPattern> sync_patterns{ { 0x44894489 & sync_mask, sync_mask } };
+    if (opt.encoding != Encoding::MFM)
+    {
+        for (auto am : { 0xaa222888, 0xaa22288a, 0xaa2228a8, 0xaa2228aa, 0xaa2a2a88, 0xaa222a8a, 0xaa222aa8 })
+            sync_patterns.push_back({ am });
+    }
+
+    auto candidates = bitbuf.find_sync(sync_patterns);
+    auto is_candidate = [&](uint32_t dw) {
+        return std::any_of(sync_patterns.begin(), sync_patterns.end(), [&](const SyncPattern& p) { return p.matches(dw); });
+    };
+
     while (!bitbuf.wrapped())
     {
         // Give up if no headers were found in the first revolution
         if (!track.size() && bitbuf.tell() > track.tracklen)
             break;
 
-        dword = (dword << 1) | bitbuf.read1();
+        auto max_bits = track.size() ? std::numeric_limits<int>::max() : (track.tracklen - bitbuf.tell() + 1);
+        if (!bitbuf.shift_until(dword, max_bits, is_candidate, candidates))
+            continue;
 
         if ((dword & sync_mask) == 0x44894489)
         {
@@ -1432,6 +1579,20 @@ void scan_bitstream_mfm_fm(TrackData& trackdata)
     trackdata.add(std::move(track));
 }
 
+// Decode the flux using a single set of PLL parameters, and scan the result.
+// The returned track data holds just the bitstream and the sectors found in it.
+static TrackData scan_flux_mfm_fm_attempt(const CompactFlux& flux_revs, const CylHead& cylhead,
+    DataRate datarate, int pll_adjust, int flux_scale)
+{
+    TrackData attempt(cylhead);
+
+    FluxDecoder decoder(flux_revs, ::bitcell_ns(datarate), flux_scale, pll_adjust);
+    attempt.add(BitBuffer(datarate, decoder));
+    scan_bitstream_mfm_fm(attempt);
+
+    return attempt;
+}
+
 void scan_flux_mfm_fm(TrackData& trackdata, DataRate last_datarate)
 {
     // Small speed variations to simulate jitter.
@@ -1448,27 +1609,86 @@ void scan_flux_mfm_fm(TrackData& trackdata, DataRate last_datarate)
     std::vector<DataRate> datarates = { last_datarate, DataRate::_250K, DataRate::_500K, DataRate::_300K, DataRate::_1M };
     datarates.erase(std::next(std::find(datarates.rbegin(), datarates.rend(), last_datarate)).base());
 
+    // PLL adjustment and flux scale combinations, in the order they're tried.
+    std::vector<std::pair<int, int>> attempts;
+    for (auto pll_adjust : pll_adjusts)
+        for (auto flux_scale : flux_scales)
+            attempts.emplace_back(pll_adjust, flux_scale);
+
+    const auto& flux_revs = trackdata.flux();
+
+    // Tracks already being decoded on a pool worker (preload or copy) are
+    // decoded sequentially, as the other workers are keeping the cores busy.
+    auto threads = (opt.mt && ThreadPool::get_thread_count() > 1 && !ThreadPool::is_worker_thread()) ?
+        std::min(ThreadPool::get_thread_count(), static_cast<int>(attempts.size()) - 1) : 0;
+
     for (auto datarate : datarates)
     {
-        for (auto pll_adjust : pll_adjusts)
+        // The first attempt is usually enough, and an empty track means the
+        // wrong data rate, so there's nothing to gain from running it early.
+        trackdata.add(scan_flux_mfm_fm_attempt(flux_revs, trackdata.cylhead,
+            datarate, attempts[0].first, attempts[0].second));
+
+        // Try the remaining PLL combinations until the track is error free.
+        if (!trackdata.track().has_good_data())
         {
-            for (auto flux_scale : flux_scales)
+            if (threads > 0)
             {
-                FluxDecoder decoder(trackdata.flux(), ::bitcell_ns(datarate),
-                    flux_scale, pll_adjust);
-                BitBuffer bitbuf(datarate, decoder);
+                // Decode the remaining combinations concurrently, but merge the
+                // results in sequential order so the output is deterministic.
+                // The pool is kept for later tracks, to avoid the thread start-up.
+                static ThreadPool pool(threads);
+                std::atomic_bool done{ false };
+                std::vector<std::future<TrackData>> rets;
+
+                // However we leave, abandon any pending decodes and wait for
+                // those still running, as they refer to our locals.
+                struct AbandonDecodes
+                {
+                    std::atomic_bool& done;
+                    std::vector<std::future<TrackData>>& rets;
 
-                trackdata.add(std::move(bitbuf));
-                scan_bitstream_mfm_fm(trackdata);
+                    ~AbandonDecodes()
+                    {
+                        done = true;
+                        for (auto& ret : rets)
+                        {
+                            if (ret.valid())
+                                ret.wait();
+                        }
+                    }
+                } abandon{ done, rets };
 
-                // Stop scaling if the track is error free.
-                if (trackdata.track().has_good_data())
-                    break;
+                for (auto it = std::next(attempts.begin()); it != attempts.end(); ++it)
+                {
+                    rets.push_back(pool.enqueue([&done, &flux_revs, cylhead = trackdata.cylhead,
+                        datarate, pll_adjust = it->first, flux_scale = it->second]() {
+                            return done ? TrackData() : scan_flux_mfm_fm_attempt(flux_revs,
+                                cylhead, datarate, pll_adjust, flux_scale);
+                        }));
+                }
+
+                for (auto& ret : rets)
+                {
+                    trackdata.add(ret.get());
+
+                    // Stop once the track is error free.
+                    if (trackdata.track().has_good_data())
+                        break;
+                }
             }
+            else
+            {
+                for (auto it = std::next(attempts.begin()); it != attempts.end(); ++it)
+                {
+                    trackdata.add(scan_flux_mfm_fm_attempt(flux_revs, trackdata.cylhead,
+                        datarate, it->first, it->second));
 
-            // Stop adjusting PLL if the track is error free.
-            if (trackdata.track().has_good_data())
-                break;
+                    // Stop adjusting PLL if the track is error free.
+                    if (trackdata.track().has_good_data())
+                        break;
+                }
+            }
         }
 
         // Stop trying data rates when we find something.
@@ -1497,6 +1717,12 @@ void scan_bitstream_agat(TrackData& trackdata)
     bitbuf.seek(0);
     bitbuf.encoding = Encoding::MFM;
     track.tracklen = bitbuf.track_bitsize();
+    auto trace = opt.debug && opt.encoding == Encoding::Agat;
+
+    // Tracing reports every bit position, so only jump between prologues otherwise.
+    std::vector<int> candidates;
+    if (!trace)
+        candidates = bitbuf.find_sync({ { 0x89245555 }, { 0x44922d55 }, { 0x44905555 } });
 
     while (!bitbuf.wrapped())
     {
@@ -1504,8 +1730,19 @@ void scan_bitstream_agat(TrackData& trackdata)
         if (!track.size() && bitbuf.tell() > track.tracklen)
             break;
 
-        dword = (dword << 1) | bitbuf.read1();
-        if (opt.debug && opt.encoding == Encoding::Agat)
+        auto max_bits = track.size() ? std::numeric_limits<int>::max() : (track.tracklen - bitbuf.tell() + 1);
+        auto is_prologue = [&](uint64_t dw) {
+            auto prologue = dw & 0x1ffffffff;
+            return trace || prologue == 0x89245555 || prologue == 0x44922d55 || prologue == 0x44905555;
+        };
+
+        if (trace ? !bitbuf.shift_until(dword, max_bits, is_prologue) :
+            !bitbuf.shift_until(dword, max_bits, is_prologue, candidates))
+        {
+            continue;
+        }
+
+        if (trace)
             util::cout << util::fmt("  s_b_agat %016lx c:h %d:%d at %d\n",
                 dword, trackdata.cylhead.cyl, trackdata.cylhead.head, bitbuf.tell());
 
@@ -1954,12 +2191,12 @@ void scan_bitstream_vista(TrackData& trackdata)
     track.tracklen = bitbuf.track_bitsize();
 
     uint32_t dword = 0;
+    auto candidates = bitbuf.find_sync({ { 0xaaaaaaaa } });
+
     while (!bitbuf.wrapped())
     {
-        dword = (dword << 1) | bitbuf.read1();
-
         // Search for 00 00 MFM pattern in potential preamble.
-        if (dword != 0xaaaaaaaa)
+        if (!bitbuf.shift_until(dword, std::numeric_limits<int>::max(), [](uint32_t dw) { return dw == 0xaaaaaaaa; }, candidates))
             continue;
 
         int zero_bits = 16;
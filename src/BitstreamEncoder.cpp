@@ -131,46 +131,26 @@ void generate_bitstream(TrackData& trackdata)
 
 void generate_flux(TrackData& trackdata)
 {
-    uint8_t last_bit{ 0 }, curr_bit{ 0 };
     auto& bitbuf = trackdata.bitstream();
-    auto ns_per_bitcell = bitcell_ns(bitbuf.datarate);
-    bitbuf.seek(0);
-
-    uint32_t flux_time{ 0 };
+    FluxEncoder encoder(trackdata.cylhead, bitbuf.datarate);
     FluxData flux_data{};
-    std::vector<uint32_t> flux_times{};
+
+    auto& flux_times = encoder.flux_times();
     flux_times.reserve(bitbuf.size());
 
-    while (!bitbuf.wrapped())
+    // Split revolutions at each index, as a read through the buffer would see them.
+    auto bitpos = 0;
+    for (auto index_pos = bitbuf.next_index(0); index_pos < bitbuf.size(); index_pos = bitbuf.next_index(index_pos))
     {
-        auto next_bit{ bitbuf.read1() };
+        encoder.add(bitbuf.data(), bitpos, index_pos - bitpos);
+        bitpos = index_pos;
 
-        flux_time += ns_per_bitcell;
-        if (curr_bit)
-        {
-            if (trackdata.cylhead.cyl < 40)
-            {
-                flux_times.push_back(flux_time);
-                flux_time = 0;
-            }
-            else
-            {
-                auto pre_comp_ns{ (last_bit == next_bit) ? 0 : (last_bit ? +240 : -240) };
-                flux_times.push_back(flux_time + pre_comp_ns);
-                flux_time = 0 - pre_comp_ns;
-            }
-        }
-
-        last_bit = curr_bit;
-        curr_bit = next_bit;
-
-        if (bitbuf.index())
-        {
-            flux_data.push_back(std::move(flux_times));
-            flux_times.clear();
-        }
+        flux_data.push_back(std::move(flux_times));
+        flux_times.clear();
     }
 
+    encoder.add(bitbuf.data(), bitpos, bitbuf.size() - bitpos);
+
     if (flux_data.empty() || !flux_times.empty())
         flux_data.push_back(std::move(flux_times));
 
@@ -26,6 +26,11 @@ void BitstreamTrackBuilder::addRawBit(bool bit)
     m_buffer.add(bit);
 }
 
+void BitstreamTrackBuilder::addRawBits(uint32_t bits, int num_bits)
+{
+    m_buffer.add(bits, num_bits);
+}
+
 void BitstreamTrackBuilder::addCrc(int size)
 {
     auto old_bitpos{ m_buffer.tell() };
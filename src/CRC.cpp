@@ -0,0 +1,347 @@
+// CRC-16-CCITT and CRC-32 implementations
+//
+// Both use slice-by-8 tables, with longer blocks folded using PCLMULQDQ on
+// CPUs that support it. Folding reduces the block to a congruent 16 bytes,
+// which are then finished by the tables along with any trailing bytes.
+
+#include "SAMdisk.h"
+#include "CRC16.h"
+#include "CRC32.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_CLMUL_CRC
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_CLMUL
+#else
+#define TARGET_CLMUL __attribute__((target("pclmul,ssse3")))
+#endif
+#endif
+
+namespace
+{
+
+#ifdef HAVE_CLMUL_CRC
+// Shorter blocks aren't worth the set-up cost of folding.
+constexpr size_t MIN_CLMUL_LEN = 128;
+
+bool cpu_has_clmul()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) && (info[2] & (1 << 9));    // PCLMULQDQ and SSSE3
+#else
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+#endif
+}
+
+bool use_clmul()
+{
+    static const bool clmul = cpu_has_clmul();
+    return clmul;
+}
+
+// x^n mod P, for a non-reflected polynomial with the given degree.
+uint64_t xpow_mod(int n, uint32_t poly, int degree)
+{
+    uint64_t r = 1;
+    while (n-- > 0)
+    {
+        r <<= 1;
+        if (r & (1ULL << degree))
+            r ^= (1ULL << degree) | poly;
+    }
+    return r;
+}
+
+// Fold constants for a distance of one block (128 bits) and four (512 bits).
+// The low qword multiplies the low half of the block, the high the high.
+struct FoldConstants
+{
+    __m128i k128;
+    __m128i k512;
+};
+
+// Non-reflected CRCs are byte-swapped into polynomial order on load.
+template <bool REFLECTED>
+TARGET_CLMUL inline __m128i load_block(const uint8_t* pb)
+{
+    auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb));
+    return REFLECTED ? x : _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+TARGET_CLMUL inline __m128i fold_block(__m128i x, __m128i k, __m128i next)
+{
+    auto lo = _mm_clmulepi64_si128(x, k, 0x00);
+    auto hi = _mm_clmulepi64_si128(x, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), next);
+}
+
+// Fold a run of 16-byte blocks, with the CRC state already positioned in
+// init, and store the congruent 16-byte remainder for a zero-state finish.
+template <bool REFLECTED>
+TARGET_CLMUL void fold_blocks(const uint8_t* pb, size_t blocks, __m128i init, const FoldConstants& k, uint8_t* out)
+{
+    auto x0 = _mm_xor_si128(load_block<REFLECTED>(pb), init);
+    pb += 16;
+    --blocks;
+
+    // Four independent lanes hide the multiply latency on long blocks.
+    if (blocks >= 7)
+    {
+        auto x1 = load_block<REFLECTED>(pb);
+        auto x2 = load_block<REFLECTED>(pb + 16);
+        auto x3 = load_block<REFLECTED>(pb + 32);
+        pb += 48;
+        blocks -= 3;
+
+        for (; blocks >= 4; blocks -= 4, pb += 64)
+        {
+            x0 = fold_block(x0, k.k512, load_block<REFLECTED>(pb));
+            x1 = fold_block(x1, k.k512, load_block<REFLECTED>(pb + 16));
+            x2 = fold_block(x2, k.k512, load_block<REFLECTED>(pb + 32));
+            x3 = fold_block(x3, k.k512, load_block<REFLECTED>(pb + 48));
+        }
+
+        x0 = fold_block(x0, k.k128, x1);
+        x0 = fold_block(x0, k.k128, x2);
+        x0 = fold_block(x0, k.k128, x3);
+    }
+
+    for (; blocks > 0; --blocks, pb += 16)
+        x0 = fold_block(x0, k.k128, load_block<REFLECTED>(pb));
+
+    if (!REFLECTED)
+        x0 = _mm_shuffle_epi8(x0, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), x0);
+}
+
+const FoldConstants& crc16_fold_constants()
+{
+    static const FoldConstants k{
+        _mm_set_epi64x(static_cast<int64_t>(xpow_mod(192, CRC16::POLYNOMIAL, 16)),
+                       static_cast<int64_t>(xpow_mod(128, CRC16::POLYNOMIAL, 16))),
+        _mm_set_epi64x(static_cast<int64_t>(xpow_mod(576, CRC16::POLYNOMIAL, 16)),
+                       static_cast<int64_t>(xpow_mod(512, CRC16::POLYNOMIAL, 16)))
+    };
+    return k;
+}
+
+const FoldConstants& crc32_fold_constants()
+{
+    // Bit-reflected x^(n+32) mod P for the low halves and x^(n-32) mod P for
+    // the high, each shifted left one bit to allow for the reflected multiply.
+    static const FoldConstants k{
+        _mm_set_epi64x(0x0ccaa009e, 0x1751997d0),
+        _mm_set_epi64x(0x1c6e41596, 0x154442bd4)
+    };
+    return k;
+}
+#endif // HAVE_CLMUL_CRC
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////
+
+std::array<std::array<uint16_t, 256>, 8> CRC16::s_crc_lookup;
+std::once_flag CRC16::flag;
+
+
+CRC16::CRC16(uint16_t init_)
+{
+    std::call_once(flag, init_crc_table);
+    init(init_);
+}
+
+CRC16::CRC16(const void* buf, size_t len, uint16_t init_)
+{
+    std::call_once(flag, init_crc_table);
+    init(init_);
+    add(buf, len);
+}
+
+/*static*/ void CRC16::init_crc_table()
+{
+    for (uint16_t i = 0; i < 256; ++i)
+    {
+        uint16_t crc = i << 8;
+
+        for (int j = 0; j < 8; ++j)
+            crc = (crc << 1) ^ ((crc & 0x8000) ? POLYNOMIAL : 0);
+
+        s_crc_lookup[0][i] = crc;
+    }
+
+    // Each further table gives the CRC of a byte followed by n zero bytes.
+    for (size_t n = 1; n < s_crc_lookup.size(); ++n)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            auto crc = s_crc_lookup[n - 1][i];
+            s_crc_lookup[n][i] = (crc << 8) ^ s_crc_lookup[0][crc >> 8];
+        }
+    }
+}
+
+CRC16::operator uint16_t () const
+{
+    return m_crc;
+}
+
+void CRC16::init(uint16_t init_crc)
+{
+    m_crc = init_crc;
+}
+
+uint16_t CRC16::add(int byte)
+{
+    m_crc = (m_crc << 8) ^ s_crc_lookup[0][((m_crc >> 8) ^ byte) & 0xff];
+    return m_crc;
+}
+
+uint16_t CRC16::add(int byte, size_t len)
+{
+    while (len-- > 0)
+        add(byte);
+
+    return m_crc;
+}
+
+uint16_t CRC16::add(const void* buf, size_t len)
+{
+    const uint8_t* pb = reinterpret_cast<const uint8_t*>(buf);
+
+#ifdef HAVE_CLMUL_CRC
+    if (len >= MIN_CLMUL_LEN && use_clmul())
+    {
+        // The CRC state is XORed into the first two bytes of the block.
+        auto fold_len = len & ~static_cast<size_t>(15);
+        auto init_state = _mm_set_epi64x(static_cast<int64_t>(static_cast<uint64_t>(m_crc) << 48), 0);
+
+        uint8_t folded[16];
+        fold_blocks<false>(pb, fold_len / 16, init_state, crc16_fold_constants(), folded);
+
+        m_crc = 0;
+        for (auto b : folded)
+            add(b);
+
+        pb += fold_len;
+        len -= fold_len;
+    }
+#endif
+
+    const auto& t = s_crc_lookup;
+    for (; len >= 8; len -= 8, pb += 8)
+    {
+        m_crc = t[7][pb[0] ^ (m_crc >> 8)] ^ t[6][pb[1] ^ (m_crc & 0xff)] ^
+            t[5][pb[2]] ^ t[4][pb[3]] ^ t[3][pb[4]] ^ t[2][pb[5]] ^ t[1][pb[6]] ^ t[0][pb[7]];
+    }
+
+    while (len-- > 0)
+        add(*pb++);
+
+    return m_crc;
+}
+
+uint8_t CRC16::msb() const
+{
+    return m_crc >> 8;
+}
+
+uint8_t CRC16::lsb() const
+{
+    return m_crc & 0xff;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+std::array<std::array<uint32_t, 256>, 8> CRC32::s_crc_lookup;
+std::once_flag CRC32::flag;
+
+
+CRC32::CRC32(uint32_t init_)
+{
+    std::call_once(flag, init_crc_table);
+    init(init_);
+}
+
+CRC32::CRC32(const void* buf, size_t len, uint32_t init_)
+{
+    std::call_once(flag, init_crc_table);
+    init(init_);
+    add(buf, len);
+}
+
+/*static*/ void CRC32::init_crc_table()
+{
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t crc = i;
+
+        for (int j = 0; j < 8; ++j)
+            crc = (crc >> 1) ^ ((crc & 1) ? POLYNOMIAL : 0);
+
+        s_crc_lookup[0][i] = crc;
+    }
+
+    // Each further table gives the CRC of a byte followed by n zero bytes.
+    for (size_t n = 1; n < s_crc_lookup.size(); ++n)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            auto crc = s_crc_lookup[n - 1][i];
+            s_crc_lookup[n][i] = (crc >> 8) ^ s_crc_lookup[0][crc & 0xff];
+        }
+    }
+}
+
+CRC32::operator uint32_t () const
+{
+    return m_crc;
+}
+
+void CRC32::init(uint32_t init_crc)
+{
+    m_crc = init_crc;
+}
+
+uint32_t CRC32::add(const void* buf, size_t len)
+{
+    const uint8_t* pb = reinterpret_cast<const uint8_t*>(buf);
+    const auto& t = s_crc_lookup;
+    uint32_t crc = ~m_crc;
+
+#ifdef HAVE_CLMUL_CRC
+    if (len >= MIN_CLMUL_LEN && use_clmul())
+    {
+        // The CRC state is XORed into the first four bytes of the block.
+        auto fold_len = len & ~static_cast<size_t>(15);
+        auto init_state = _mm_cvtsi32_si128(static_cast<int>(crc));
+
+        uint8_t folded[16];
+        fold_blocks<true>(pb, fold_len / 16, init_state, crc32_fold_constants(), folded);
+
+        crc = 0;
+        for (auto b : folded)
+            crc = (crc >> 8) ^ t[0][(crc ^ b) & 0xff];
+
+        pb += fold_len;
+        len -= fold_len;
+    }
+#endif
+
+    for (; len >= 8; len -= 8, pb += 8)
+    {
+        auto lo = crc ^ (pb[0] | (pb[1] << 8) | (pb[2] << 16) | (static_cast<uint32_t>(pb[3]) << 24));
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+            t[3][pb[4]] ^ t[2][pb[5]] ^ t[1][pb[6]] ^ t[0][pb[7]];
+    }
+
+    while (len-- > 0)
+        crc = (crc >> 8) ^ t[0][(crc ^ *pb++) & 0xff];
+
+    m_crc = ~crc;
+    return m_crc;
+}
@@ -0,0 +1,116 @@
+// Compact in-memory flux storage
+
+#include "SAMdisk.h"
+
+CompactFlux::CompactFlux(const FluxData& flux_revs)
+{
+    size_t words = 0;
+    for (auto& flux_times : flux_revs)
+        words += flux_times.size();
+
+    unshared_words().reserve(words);
+    m_rev_offsets.reserve(flux_revs.size() + 1);
+    m_rev_counts.reserve(flux_revs.size());
+
+    for (auto& flux_times : flux_revs)
+        add(flux_times);
+
+    m_words->shrink_to_fit();
+}
+
+bool CompactFlux::empty() const
+{
+    return m_rev_counts.empty();
+}
+
+int CompactFlux::size() const
+{
+    return static_cast<int>(m_rev_counts.size());
+}
+
+int CompactFlux::flux_count() const
+{
+    return std::accumulate(m_rev_counts.begin(), m_rev_counts.end(), 0);
+}
+
+int CompactFlux::flux_count(int rev) const
+{
+    return m_rev_counts[rev];
+}
+
+CompactFlux::const_iterator CompactFlux::begin(int rev) const
+{
+    return const_iterator(m_words->data() + m_rev_offsets[rev]);
+}
+
+CompactFlux::const_iterator CompactFlux::end(int rev) const
+{
+    return const_iterator(m_words->data() + m_rev_offsets[rev + 1]);
+}
+
+CompactFlux::Revolution CompactFlux::operator[](int rev) const
+{
+    return { begin(rev), end(rev) };
+}
+
+CompactFlux::Revolution CompactFlux::back() const
+{
+    assert(!empty());
+    return (*this)[size() - 1];
+}
+
+void CompactFlux::clear()
+{
+    m_words.reset();
+    m_rev_offsets.assign(1, 0);
+    m_rev_counts.clear();
+}
+
+void CompactFlux::add(const std::vector<uint32_t>& flux_times)
+{
+    auto& words = unshared_words();
+
+    for (auto time_ns : flux_times)
+    {
+        if (time_ns && time_ns <= 0xffff)
+            words.push_back(static_cast<uint16_t>(time_ns));
+        else
+        {
+            words.push_back(0);
+            words.push_back(static_cast<uint16_t>(time_ns));
+            words.push_back(static_cast<uint16_t>(time_ns >> 16));
+        }
+    }
+
+    m_rev_offsets.push_back(words.size());
+    m_rev_counts.push_back(static_cast<int>(flux_times.size()));
+}
+
+// Copies of the flux share its words, which are only copied if more are
+// added to one of them.
+std::vector<uint16_t>& CompactFlux::unshared_words()
+{
+    if (!m_words)
+        m_words = std::make_shared<std::vector<uint16_t>>();
+    else if (m_words.use_count() > 1)
+        m_words = std::make_shared<std::vector<uint16_t>>(*m_words);
+
+    return *m_words;
+}
+
+FluxData CompactFlux::expand() const
+{
+    FluxData flux_revs;
+    flux_revs.reserve(m_rev_counts.size());
+
+    for (auto rev = 0; rev < size(); ++rev)
+    {
+        std::vector<uint32_t> flux_times;
+        flux_times.reserve(m_rev_counts[rev]);
+        for (auto time_ns : (*this)[rev])
+            flux_times.push_back(time_ns);
+        flux_revs.push_back(std::move(flux_times));
+    }
+
+    return flux_revs;
+}
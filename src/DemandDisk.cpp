@@ -2,16 +2,21 @@
 
 #include "SAMdisk.h"
 #include "DemandDisk.h"
+#include "ThreadPool.h"
 
 // Storage for class statics.
 constexpr int DemandDisk::FIRST_READ_REVS;
 constexpr int DemandDisk::REMAIN_READ_REVS;
+constexpr int DemandDisk::MAX_STALLED_RESCANS;
 
 
 void DemandDisk::extend(const CylHead& cylhead)
 {
-    // Access the track entry to pre-extend the disk ahead of loading it
-    m_trackdata[cylhead].cylhead = cylhead;
+    // Add the track entry to pre-extend the disk ahead of loading it
+    auto& track_slot = slot(cylhead);
+    std::lock_guard<std::mutex> lock(track_slot.mutex);
+    track_slot.trackdata.cylhead = cylhead;
+    add_slot(cylhead);
 }
 
 bool DemandDisk::supports_retries() const
@@ -20,46 +25,145 @@ bool DemandDisk::supports_retries() const
     return false;
 }
 
-const TrackData& DemandDisk::read(const CylHead& cylhead, bool uncached)
+// Rescans can be merged by sector offset if both tracks have them, and
+// they're the same data rate, as Track::add requires.
+static bool can_merge(const Track& track, const Track& rescan_track)
 {
-    if (uncached || !m_loaded[cylhead])
-    {
-        // Quick first read, plus sector-based conversion
-        auto trackdata = load(cylhead, true);
-        auto& track = trackdata.track();
+    auto has_offsets = [](const Track& t) {
+        return std::all_of(t.begin(), t.end(), [](const Sector& s) { return s.offset != 0; });
+    };
 
-        // If the disk supports sector-level retries we won't duplicate them.
-        auto retries = supports_retries() ? 0 : opt.retries;
-        auto rescans = opt.rescans;
+    return !track.empty() && !rescan_track.empty() &&
+        track[0].datarate == rescan_track[0].datarate &&
+        has_offsets(track) && has_offsets(rescan_track);
+}
 
-        // Consider rescans and error retries.
-        while (rescans > 0 || retries > 0)
-        {
-            // If no more rescans are required, stop when there's nothing to fix.
-            if (rescans <= 0 && track.has_good_data())
-                break;
+// Merge a rescan into the sectors from earlier reads, returning true if it
+// added a sector or a new data copy, or improved an existing one.
+static bool merge_rescan(Track& track, const Track& rescan_track)
+{
+    auto changed = false;
+    track.tracklen = std::max(track.tracklen, rescan_track.tracklen);
+    track.tracktime = std::max(track.tracktime, rescan_track.tracktime);
 
-            auto rescan_trackdata = load(cylhead);
-            auto& rescan_track = rescan_trackdata.track();
+    for (auto sector : rescan_track)
+        changed |= track.add(std::move(sector)) != Track::AddResult::Unchanged;
 
-            // If the rescan found more sectors, use the new track data.
-            if (rescan_track.size() > track.size())
-                std::swap(trackdata, rescan_trackdata);
+    return changed;
+}
 
-            // Flux reads include 5 revolutions, others just 1
-            auto revs = trackdata.has_flux() ? REMAIN_READ_REVS : 1;
-            rescans -= revs;
-            retries -= revs;
-        }
+const TrackData& DemandDisk::read(const CylHead& cylhead, bool uncached)
+{
+    {
+        // Hold the slot lock while loading, so each track is loaded once,
+        // but different tracks can be loaded concurrently.
+        auto& track_slot = slot(cylhead);
+        std::lock_guard<std::mutex> lock(track_slot.mutex);
 
-        std::lock_guard<std::mutex> lock(m_trackdata_mutex);
-        m_trackdata[cylhead] = std::move(trackdata);
-        m_loaded[cylhead] = true;
+        if (uncached || !m_loaded[cylhead])
+        {
+            // Quick first read, plus sector-based conversion
+            auto trackdata = load(cylhead, true);
+            trackdata.hint = m_decode_hint;
+
+            // Sectors from every read are merged here, while trackdata keeps
+            // the single read with the most sectors for its bitstream/flux.
+            auto track = trackdata.track();
+            auto merged = false;
+
+            // If the disk supports sector-level retries we won't duplicate them.
+            auto retries = supports_retries() ? 0 : opt.retries;
+            auto rescans = opt.rescans;
+            auto stalled = 0, spare_limit = retries;
+
+            // Spare retries are only shared by tracks read in turn by the
+            // caller, not by pool workers, so each track's budget doesn't
+            // depend on which worker finishes first.
+            auto share_spares = !ThreadPool::is_worker_thread();
+
+            // Consider rescans and error retries.
+            while (rescans > 0 || retries > 0)
+            {
+                // Stop when there's nothing to fix, unless rescans are still
+                // finding new sectors or data. Note this ends --rescans early
+                // at the first unchanged rescan of an error-free track.
+                if (track.has_good_data() && (rescans <= 0 || stalled))
+                    break;
+
+                // Give up on errors that haven't responded to recent retries,
+                // leaving the remaining budget for tracks that are improving.
+                if (rescans <= 0 && stalled >= MAX_STALLED_RESCANS)
+                    break;
+
+                auto rescan_trackdata = load(cylhead);
+                rescan_trackdata.hint = m_decode_hint;
+                auto& rescan_track = rescan_trackdata.track();
+
+                // Without offsets we can only keep the read with most sectors.
+                auto improved = false;
+                if (can_merge(track, rescan_track))
+                {
+                    improved = merge_rescan(track, rescan_track);
+                    merged |= improved;
+                }
+                else if (rescan_track.size() > track.size())
+                {
+                    // This is also the read kept below, so nothing to merge.
+                    track = rescan_track;
+                    improved = true;
+                    merged = false;
+                }
+
+                // New copies of bad sectors count as progress, as varying
+                // reads suggest a marginal sector that may yet give good data.
+                stalled = improved ? 0 : stalled + 1;
+
+                // If the rescan found more sectors, use the new track data.
+                if (rescan_track.size() > trackdata.track().size())
+                    std::swap(trackdata, rescan_trackdata);
+
+                // Flux reads include 5 revolutions, others just 1
+                auto revs = trackdata.has_flux() ? REMAIN_READ_REVS : 1;
+                rescans -= revs;
+                retries -= revs;
+
+                // A track still improving when its own retries run out may use
+                // those left by other tracks, up to the same number again.
+                if (share_spares && retries <= 0 && rescans <= 0 && !stalled && spare_limit > 0 &&
+                    !track.has_good_data())
+                {
+                    auto spare = take_spare_revs(std::min(revs, spare_limit));
+                    retries += spare;
+                    spare_limit -= spare;
+                }
+            }
+
+            // Return unused retries to the pool.
+            if (share_spares && retries > 0)
+                m_spare_revs += retries;
+
+            // Merge the combined sectors into the kept read, which they include.
+            if (merged)
+                trackdata.add(std::move(track));
+
+            track_slot.trackdata = std::move(trackdata);
+            add_slot(cylhead);
+            m_loaded[cylhead] = true;
+        }
     }
 
     return Disk::read(cylhead);
 }
 
+int DemandDisk::take_spare_revs(int revs)
+{
+    auto spare = m_spare_revs.load();
+    while (spare > 0 && !m_spare_revs.compare_exchange_weak(spare, spare - std::min(spare, revs)))
+        ;
+
+    return std::max(std::min(spare, revs), 0);
+}
+
 void DemandDisk::save(TrackData&/*trackdata*/)
 {
     throw util::exception("writing to this device is not currently supported");
@@ -68,12 +172,16 @@ void DemandDisk::save(TrackData&/*trackdata*/)
 const TrackData& DemandDisk::write(TrackData&& trackdata)
 {
     save(trackdata);
-    m_loaded[trackdata.cylhead] = true;
+    {
+        std::lock_guard<std::mutex> lock(slot(trackdata.cylhead).mutex);
+        m_loaded[trackdata.cylhead] = true;
+    }
     return Disk::write(std::move(trackdata));
 }
 
 void DemandDisk::clear()
 {
     Disk::clear();
-    m_loaded.reset();
+    m_loaded.fill(false);
+    m_spare_revs = 0;
 }
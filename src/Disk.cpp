@@ -20,28 +20,87 @@ Range Disk::range() const
 
 int Disk::cyls() const
 {
-    return m_trackdata.empty() ? 0 : (m_trackdata.rbegin()->first.cyl + 1);
+    return m_cyls;
 }
 
 int Disk::heads() const
 {
-    if (m_trackdata.empty())
-        return 0;
+    return m_heads;
+}
 
-    auto it = std::find_if(m_trackdata.begin(), m_trackdata.end(), [](const std::pair<const CylHead, const TrackData>& p) {
-        return p.first.head != 0;
-        });
+Disk::TrackSlot& Disk::slot(const CylHead& cylhead)
+{
+    // Image readers may give tracks beyond what the slots can hold.
+    if (cylhead.cyl < 0 || cylhead.cyl >= MAX_DISK_CYLS || cylhead.head < 0 || cylhead.head >= MAX_DISK_HEADS)
+        throw util::exception(cylhead, " is outside the supported disk geometry");
+
+    return (*m_slots)[cylhead];
+}
+
+// Mark a slot as holding a track, extending the disk to include it.
+// The caller must own the slot lock, unless no reads can be in progress.
+void Disk::add_slot(const CylHead& cylhead)
+{
+    auto& track_slot = slot(cylhead);
+    if (track_slot.present)
+        return;
+
+    track_slot.present = true;
 
-    return (it != m_trackdata.end()) ? 2 : 1;
+    auto cyls = m_cyls.load();
+    while (cyls < cylhead.cyl + 1 && !m_cyls.compare_exchange_weak(cyls, cylhead.cyl + 1))
+        ;
+
+    auto heads = m_heads.load();
+    auto min_heads = cylhead.head ? 2 : 1;
+    while (heads < min_heads && !m_heads.compare_exchange_weak(heads, min_heads))
+        ;
 }
 
+// Recalculate the disk extent after tracks are removed or moved.
+void Disk::update_extent()
+{
+    auto cyls = 0, heads = 0;
+
+    for (auto cyl = 0; cyl < MAX_DISK_CYLS; ++cyl)
+    {
+        for (auto head = 0; head < MAX_DISK_HEADS; ++head)
+        {
+            if (slot(CylHead(cyl, head)).present)
+            {
+                cyls = cyl + 1;
+                heads = std::max(heads, head ? 2 : 1);
+            }
+        }
+    }
+
+    m_cyls = cyls;
+    m_heads = heads;
+}
+
+
+bool Disk::supports_concurrent_reads() const
+{
+    // Devices must override this, as they can only read one track at a time.
+    return true;
+}
 
 bool Disk::preload(const Range& range_, int cyl_step)
 {
     // No pre-loading if multi-threading disabled, or only a single core
-    if (!opt.mt || ThreadPool::get_thread_count() <= 1)
+    if (!opt.mt || ThreadPool::get_thread_count() <= 1 || !supports_concurrent_reads())
         return false;
 
+    // Decode the first track up front to seed the decode hint, then freeze
+    // it so the remaining tracks don't depend on the order workers finish.
+    auto first = true;
+    range_.each([&](const CylHead cylhead) {
+        if (first)
+            read_track(cylhead * cyl_step);
+        first = false;
+        });
+
+    DecodeHint::Freeze freeze(*m_decode_hint);
     ThreadPool pool;
     std::vector<std::future<void>> rets;
 
@@ -59,36 +118,59 @@ bool Disk::preload(const Range& range_, int cyl_step)
 
 void Disk::clear()
 {
-    m_trackdata.clear();
+    for (auto& track_slot : *m_slots)
+    {
+        track_slot.trackdata = TrackData();
+        track_slot.present = false;
+    }
+
+    update_extent();
 }
 
 
 const TrackData& Disk::read(const CylHead& cylhead, bool /*uncached*/)
 {
-    // Safe look-up requires mutex ownership, in case of call from preload()
-    std::lock_guard<std::mutex> lock(m_trackdata_mutex);
-    return m_trackdata[cylhead];
+    // Safe look-up requires slot lock ownership, in case of call from preload()
+    auto& track_slot = slot(cylhead);
+    std::lock_guard<std::mutex> lock(track_slot.mutex);
+
+    // Reading a missing track extends the disk to include it, as a blank track.
+    if (!track_slot.present)
+    {
+        track_slot.trackdata.cylhead = cylhead;
+        add_slot(cylhead);
+    }
+
+    if (!track_slot.trackdata.hint)
+        track_slot.trackdata.hint = m_decode_hint;
+
+    return track_slot.trackdata;
 }
 
+// The slot lock is held while converting, which may involve a full flux
+// scan, but only blocks other users of the same track.
 const Track& Disk::read_track(const CylHead& cylhead, bool uncached)
 {
     read(cylhead, uncached);
-    std::lock_guard<std::mutex> lock(m_trackdata_mutex);
-    return m_trackdata[cylhead].track();
+    auto& track_slot = slot(cylhead);
+    std::lock_guard<std::mutex> lock(track_slot.mutex);
+    return track_slot.trackdata.track();
 }
 
 const BitBuffer& Disk::read_bitstream(const CylHead& cylhead, bool uncached)
 {
     read(cylhead, uncached);
-    std::lock_guard<std::mutex> lock(m_trackdata_mutex);
-    return m_trackdata[cylhead].bitstream();
+    auto& track_slot = slot(cylhead);
+    std::lock_guard<std::mutex> lock(track_slot.mutex);
+    return track_slot.trackdata.bitstream();
 }
 
-const FluxData& Disk::read_flux(const CylHead& cylhead, bool uncached)
+const CompactFlux& Disk::read_flux(const CylHead& cylhead, bool uncached)
 {
     read(cylhead, uncached);
-    std::lock_guard<std::mutex> lock(m_trackdata_mutex);
-    return m_trackdata[cylhead].flux();
+    auto& track_slot = slot(cylhead);
+    std::lock_guard<std::mutex> lock(track_slot.mutex);
+    return track_slot.trackdata.flux();
 }
 
 
@@ -97,10 +179,15 @@ const TrackData& Disk::write(TrackData&& trackdata)
     // Invalidate stored format, since we can no longer guarantee a match
     fmt.sectors = 0;
 
-    std::lock_guard<std::mutex> lock(m_trackdata_mutex);
+    if (!trackdata.hint)
+        trackdata.hint = m_decode_hint;
+
     auto cylhead = trackdata.cylhead;
-    m_trackdata[cylhead] = std::move(trackdata);
-    return m_trackdata[cylhead];
+    auto& track_slot = slot(cylhead);
+    std::lock_guard<std::mutex> lock(track_slot.mutex);
+    track_slot.trackdata = std::move(trackdata);
+    add_slot(cylhead);
+    return track_slot.trackdata;
 }
 
 const Track& Disk::write(const CylHead& cylhead, Track&& track)
@@ -115,7 +202,7 @@ const BitBuffer& Disk::write(const CylHead& cylhead, BitBuffer&& bitbuf)
     return read_bitstream(cylhead);
 }
 
-const FluxData& Disk::write(const CylHead& cylhead, FluxData&& flux_revs, bool normalised)
+const CompactFlux& Disk::write(const CylHead& cylhead, FluxData&& flux_revs, bool normalised)
 {
     write(TrackData(cylhead, std::move(flux_revs), normalised));
     return read_flux(cylhead);
@@ -124,7 +211,7 @@ const FluxData& Disk::write(const CylHead& cylhead, FluxData&& flux_revs, bool n
 
 void Disk::each(const std::function<void(const CylHead & cylhead, const Track & track)>& func, bool cyls_first)
 {
-    if (!m_trackdata.empty())
+    if (cyls())
     {
         range().each([&](const CylHead& cylhead) {
             func(cylhead, read_track(cylhead));
@@ -154,41 +241,46 @@ void Disk::format(const Format& new_fmt, const Data& data, bool cyls_first)
 
 void Disk::flip_sides()
 {
-    decltype(m_trackdata) trackdata;
-
-    for (auto pair : m_trackdata)
+    // Swap the tracks on each cylinder, including their presence
+    for (auto cyl = 0; cyl < MAX_DISK_CYLS; ++cyl)
     {
-        CylHead cylhead = pair.first;
-        cylhead.head ^= 1;
+        auto& slot0 = slot(CylHead(cyl, 0));
+        auto& slot1 = slot(CylHead(cyl, 1));
 
-        // Move tracks to the new head position
-        trackdata[cylhead] = std::move(pair.second);
+        std::swap(slot0.trackdata, slot1.trackdata);
+        std::swap(slot0.present, slot1.present);
     }
 
-    // Finally, swap the gutted container with the new one
-    std::swap(trackdata, m_trackdata);
+    update_extent();
 }
 
 void Disk::resize(int new_cyls, int new_heads)
 {
     if (!new_cyls && !new_heads)
     {
-        m_trackdata.clear();
+        clear();
         return;
     }
 
     // Remove tracks beyond the new extent
-    for (auto it = m_trackdata.begin(); it != m_trackdata.end(); )
+    for (auto cyl = 0; cyl < MAX_DISK_CYLS; ++cyl)
     {
-        if (it->first.cyl >= new_cyls || it->first.head >= new_heads)
-            it = m_trackdata.erase(it);
-        else
-            ++it;
+        for (auto head = 0; head < MAX_DISK_HEADS; ++head)
+        {
+            if (cyl >= new_cyls || head >= new_heads)
+            {
+                auto& track_slot = slot(CylHead(cyl, head));
+                track_slot.trackdata = TrackData();
+                track_slot.present = false;
+            }
+        }
     }
 
+    update_extent();
+
     // If the disk is too small, insert a blank track to extend it
     if (cyls() < new_cyls || heads() < new_heads)
-        m_trackdata[CylHead(new_cyls - 1, new_heads - 1)];
+        add_slot(CylHead(new_cyls - 1, new_heads - 1));
 }
 
 const Sector& Disk::get_sector(const Header& header)
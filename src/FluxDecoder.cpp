@@ -5,32 +5,27 @@
 #include "SAMdisk.h"
 #include "FluxDecoder.h"
 
-FluxDecoder::FluxDecoder(const FluxData& flux_revs, int bitcell_ns, int flux_scale_percent, int pll_adjust)
+FluxDecoder::FluxDecoder(const CompactFlux& flux_revs, int bitcell_ns, int flux_scale_percent, int pll_adjust)
     : m_flux_revs(flux_revs), m_clock(bitcell_ns), m_clock_centre(bitcell_ns),
     m_clock_min(bitcell_ns* (100 - pll_adjust) / 100),
     m_clock_max(bitcell_ns* (100 + pll_adjust) / 100),
     m_flux_scale_percent(flux_scale_percent),
-    m_pll_adjust(pll_adjust)
+    m_pll_adjust(pll_adjust), m_pll_phase(opt.pllphase)
 {
     assert(flux_revs.size());
 
-    m_rev_it = m_flux_revs.cbegin();
-    m_flux_it = (*m_rev_it).cbegin();
+    m_flux_it = m_flux_revs.begin(m_rev);
+    m_flux_end = m_flux_revs.end(m_rev);
 }
 
 int FluxDecoder::flux_revs() const
 {
-    return static_cast<int>(m_flux_revs.size());
+    return m_flux_revs.size();
 }
 
 int FluxDecoder::flux_count() const
 {
-    auto count = 0;
-
-    for (const auto& vec : m_flux_revs)
-        count += static_cast<int>(vec.size());
-
-    return count;
+    return m_flux_revs.flux_count();
 }
 
 bool FluxDecoder::index()
@@ -94,7 +89,7 @@ int FluxDecoder::next_bit()
     m_clock = std::min(std::max(m_clock_min, m_clock), m_clock_max);
 
     // Authentic PLL: Do not snap the timing window to each flux transition
-    new_flux = m_flux * (100 - opt.pllphase) / 100;
+    new_flux = m_flux * (100 - m_pll_phase) / 100;
     m_flux = new_flux;
 
     ++m_goodbits;
@@ -103,17 +98,151 @@ int FluxDecoder::next_bit()
 
 int FluxDecoder::next_flux()
 {
-    if (m_flux_it == (*m_rev_it).cend())
+    if (m_flux_it == m_flux_end)
     {
-        if (++m_rev_it == m_flux_revs.cend())
+        if (m_rev + 1 >= m_flux_revs.size())
             return -1;
 
+        ++m_rev;
         m_index = true;
-        m_flux_it = (*m_rev_it).cbegin();
-        if (m_flux_it == (*m_rev_it).cend())
+        m_flux_it = m_flux_revs.begin(m_rev);
+        m_flux_end = m_flux_revs.end(m_rev);
+        if (m_flux_it == m_flux_end)
             return -1;
     }
 
-    auto time_ns = *m_flux_it++;
+    auto time_ns = *m_flux_it;
+    ++m_flux_it;
     return time_ns;
 }
+
+void FluxDecoder::decode(std::vector<uint8_t>& data, int& bitsize,
+    std::vector<int>& indexes, std::vector<int>& sync_losses)
+{
+    // This mirrors next_bit(), with the PLL state held in locals for the
+    // duration, and the scaling and phase factors fixed up front.
+    auto clock = m_clock, flux = m_flux;
+    auto clocked_zeros = m_clocked_zeros, goodbits = m_goodbits;
+    auto index = m_index, sync_lost = m_sync_lost;
+    const auto clock_centre = m_clock_centre, clock_min = m_clock_min, clock_max = m_clock_max;
+    const auto pll_adjust = m_pll_adjust, phase_keep = 100 - m_pll_phase;
+    const auto scale = m_flux_scale_percent;
+    const auto scaled = scale != 100;
+
+    auto rev = m_rev;
+    auto p = m_flux_it, end = m_flux_end;
+
+    // Bits are gathered 64 at a time, starting with any partial byte.
+    auto bitpos = bitsize;
+    size_t byte_pos = bitpos / 8;
+    auto acc_bits = bitpos & 7;
+    uint64_t acc = acc_bits ? (data[byte_pos] & ((1U << acc_bits) - 1)) : 0;
+
+    auto flush = [&](int num_bytes) {
+        // Double the size if we run out of space
+        while (byte_pos + num_bytes > data.size())
+            data.resize(std::max(data.size() * 2, byte_pos + num_bytes));
+
+        for (auto i = 0; i < num_bytes; ++i, acc >>= 8)
+            data[byte_pos + i] = static_cast<uint8_t>(acc);
+    };
+
+    for (;;)
+    {
+        while (flux < clock / 2)
+        {
+            if (p == end)
+            {
+                if (rev + 1 == m_flux_revs.size())
+                    break;
+
+                ++rev;
+                index = true;
+                p = m_flux_revs.begin(rev);
+                end = m_flux_revs.end(rev);
+                if (p == end)
+                    break;
+            }
+
+            int new_flux = static_cast<int>(*p);
+            ++p;
+            if (new_flux == -1)
+                break;
+
+            if (scaled)
+                new_flux = new_flux * scale / 100;
+
+            flux += new_flux;
+            clocked_zeros = 0;
+        }
+
+        if (flux < clock / 2)
+            break;
+
+        flux -= clock;
+
+        uint64_t bit = 0;
+        if (flux >= clock / 2)
+        {
+            ++clocked_zeros;
+        }
+        else
+        {
+            if (clocked_zeros <= 3)
+                clock += flux * pll_adjust / 100;
+            else
+            {
+                clock += (clock_centre - clock) * pll_adjust / 100;
+
+                if (goodbits >= 256)
+                    sync_lost = true;
+
+                goodbits = 0;
+            }
+
+            clock = std::min(std::max(clock_min, clock), clock_max);
+            flux = flux * phase_keep / 100;
+            bit = 1;
+        }
+
+        ++goodbits;
+
+        if (sync_lost)
+        {
+            sync_losses.push_back(bitpos);
+            sync_lost = false;
+        }
+
+        acc |= bit << acc_bits;
+        ++bitpos;
+
+        if (++acc_bits == 64)
+        {
+            flush(8);
+            byte_pos += 8;
+            acc_bits = 0;
+        }
+
+        if (index)
+        {
+            indexes.push_back(bitpos);
+            index = false;
+        }
+    }
+
+    if (acc_bits)
+        flush((acc_bits + 7) / 8);
+
+    bitsize = bitpos;
+
+    m_clock = clock;
+    m_flux = flux;
+    m_clocked_zeros = clocked_zeros;
+    m_goodbits = goodbits;
+    m_index = index;
+    m_sync_lost = sync_lost;
+
+    m_rev = rev;
+    m_flux_it = p;
+    m_flux_end = end;
+}
@@ -0,0 +1,183 @@
+// Bitcell to flux reversal encoding, with write precompensation
+
+#include "SAMdisk.h"
+#include "FluxEncoder.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+
+int lowest_bit(uint64_t x)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// The zone covering a track starts nearest below it, with a zone for the
+// track data rate preferred over one for any rate starting at the same place.
+const PrecompZone* find_precomp_zone(const CylHead& cylhead, DataRate datarate)
+{
+    const PrecompZone* found = nullptr;
+
+    for (auto& zone : opt.precomp)
+    {
+        if (zone.cyl > cylhead.cyl ||
+            (zone.datarate != DataRate::Unknown && zone.datarate != datarate))
+            continue;
+
+        if (!found || zone.cyl > found->cyl ||
+            (zone.cyl == found->cyl && zone.datarate != DataRate::Unknown))
+            found = &zone;
+    }
+
+    return found;
+}
+
+} // namespace
+
+
+// Comma-separated zones of CYL:NS, CYL:EARLY:LATE or CYL:EARLY:LATE:RATE,
+// or "none" to disable precompensation.
+std::vector<PrecompZone> precomp_from_string(const std::string& str)
+{
+    std::vector<PrecompZone> zones;
+    if (util::lowercase(str) == "none")
+        return zones;
+
+    for (auto& spec : util::split(str, ','))
+    {
+        auto fields = util::split(spec, ':');
+        if (fields.size() < 2 || fields.size() > 4)
+            throw util::exception("invalid precomp zone '", spec, "', expected CYL:EARLY[:LATE[:RATE]]");
+
+        PrecompZone zone;
+        zone.cyl = util::str_value<int>(fields[0]);
+        zone.early_ns = zone.late_ns = util::str_value<int>(fields[1]);
+
+        if (fields.size() > 2)
+            zone.late_ns = util::str_value<int>(fields[2]);
+
+        if (fields.size() > 3)
+        {
+            zone.datarate = datarate_from_string(fields[3]);
+            if (zone.datarate == DataRate::Unknown)
+                throw util::exception("invalid data rate '", fields[3], "' in precomp zone '", spec, "'");
+        }
+
+        if (zone.cyl < 0 || zone.cyl >= MAX_TRACKS)
+            throw util::exception("invalid precomp cylinder in '", spec, "', expected 0-", MAX_TRACKS - 1);
+        if (zone.early_ns < 0 || zone.early_ns > MAX_PRECOMP_NS || zone.late_ns < 0 || zone.late_ns > MAX_PRECOMP_NS)
+            throw util::exception("invalid precomp time in '", spec, "', expected 0-", MAX_PRECOMP_NS, " (ns)");
+
+        zones.push_back(zone);
+    }
+
+    return zones;
+}
+
+
+FluxEncoder::FluxEncoder(const CylHead& cylhead, DataRate datarate, uint32_t start_time)
+    : m_bitcell_ns(bitcell_ns(datarate)), m_flux_time(start_time)
+{
+    auto zone = find_precomp_zone(cylhead, datarate);
+    if (zone)
+    {
+        m_early_ns = zone->early_ns;
+        m_late_ns = zone->late_ns;
+    }
+}
+
+void FluxEncoder::add(uint64_t bits, int num_bits)
+{
+    assert(num_bits >= 0 && num_bits <= MAX_ADD_BITS);
+
+    // Cells in time order from the lsb, after the previous two cells.
+    auto cells = ((bits & ((uint64_t(1) << num_bits) - 1)) << 2) |
+        (uint64_t(m_curr_bit) << 1) | uint64_t(m_last_bit);
+
+    // Each transition is emitted once the cell after it is known, so the
+    // one in the last new cell is left pending.
+    auto transitions = cells & (((uint64_t(1) << num_bits) - 1) << 1);
+    auto precomp = m_early_ns || m_late_ns;
+    auto prev_pos = 0;
+
+    while (transitions)
+    {
+        auto pos = lowest_bit(transitions);
+        transitions &= transitions - 1;
+
+        m_flux_time += static_cast<uint32_t>(pos - prev_pos) * m_bitcell_ns;
+        prev_pos = pos;
+
+        // Move adjacent transitions further apart, to account for attraction when written.
+        auto pre_comp_ns = 0;
+        if (precomp)
+        {
+            auto before = (cells >> (pos - 1)) & 1, after = (cells >> (pos + 1)) & 1;
+            if (before != after)
+                pre_comp_ns = before ? +m_late_ns : -m_early_ns;
+        }
+
+        m_flux_times.push_back(m_flux_time + pre_comp_ns);
+        m_flux_time = 0 - pre_comp_ns;
+    }
+
+    m_flux_time += static_cast<uint32_t>(num_bits - prev_pos) * m_bitcell_ns;
+    m_last_bit = ((cells >> num_bits) & 1) != 0;
+    m_curr_bit = ((cells >> (num_bits + 1)) & 1) != 0;
+}
+
+void FluxEncoder::add(const std::vector<uint8_t>& data, int bitpos, int num_bits)
+{
+    assert(bitpos >= 0 && num_bits >= 0 && bitpos + num_bits <= static_cast<int>(data.size()) * 8);
+
+    // Each chunk is read from a whole byte, leaving at least 56 bits after the shift.
+    constexpr int CHUNK_BITS = 56;
+    static_assert(CHUNK_BITS <= MAX_ADD_BITS, "chunk too big to add");
+
+    auto size = data.size();
+    while (num_bits > 0)
+    {
+        auto offset = static_cast<size_t>(bitpos / 8);
+        uint64_t bits = 0;
+
+        if (offset + 8 <= size)
+        {
+            auto p = data.data() + offset;
+            for (auto i = 0; i < 8; ++i)
+                bits |= uint64_t(p[i]) << (i * 8);
+        }
+        else
+        {
+            for (auto i = 0; offset + i < size; ++i)
+                bits |= uint64_t(data[offset + i]) << (i * 8);
+        }
+
+        auto chunk = std::min(num_bits, CHUNK_BITS);
+        add(bits >> (bitpos & 7), chunk);
+        bitpos += chunk;
+        num_bits -= chunk;
+    }
+}
+
+void FluxEncoder::flush()
+{
+    if (m_flux_time)
+    {
+        m_flux_times.push_back(m_flux_time);
+        m_flux_time = 0;
+    }
+}
+
+std::vector<uint32_t>& FluxEncoder::flux_times()
+{
+    return m_flux_times;
+}
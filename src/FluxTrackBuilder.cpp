@@ -5,8 +5,8 @@
 
 FluxTrackBuilder::FluxTrackBuilder(const CylHead& cylhead, DataRate datarate, Encoding encoding)
     : TrackBuilder(datarate, encoding),
-    m_cylhead(cylhead), m_bitcell_ns(bitcell_ns(datarate)),
-    m_flux_time(0U - m_bitcell_ns)
+    m_bitcell_ns(bitcell_ns(datarate)),
+    m_encoder(cylhead, datarate, 0U - m_bitcell_ns)
 {
     // We start with a negative cell time to absorb the first zero m_cur_bit.
     // This ensures the first reversal exactly matches the added data.
@@ -14,50 +14,36 @@ FluxTrackBuilder::FluxTrackBuilder(const CylHead& cylhead, DataRate datarate, En
 
 void FluxTrackBuilder::addRawBit(bool next_bit)
 {
-    m_flux_time += m_bitcell_ns;
-
-    if (m_curr_bit)
-    {
-        if (m_cylhead.cyl < 40)
-        {
-            m_flux_times.push_back(m_flux_time);
-            m_flux_time = 0;
-        }
-        else
-        {
-            // Move adjacent transitions further apart, to account for attraction when written.
-            auto pre_comp_ns{ (m_last_bit == next_bit) ? 0 : (m_last_bit ? +PRECOMP_NS : -PRECOMP_NS) };
-
-            m_flux_times.push_back(m_flux_time + pre_comp_ns);
-            m_flux_time = 0 - pre_comp_ns;
-        }
-    }
-
-    m_last_bit = m_curr_bit;
-    m_curr_bit = next_bit;
+    m_encoder.add(next_bit ? 1 : 0, 1);
+}
+
+void FluxTrackBuilder::addRawBits(uint32_t bits, int num_bits)
+{
+    if (num_bits <= 0)
+        return;
+
+    // Reverse the bits, as the encoder takes the first bit in the lsb.
+    bits = util::reverse_bits32(bits);
+
+    m_encoder.add(bits >> (32 - num_bits), num_bits);
 }
 
 void FluxTrackBuilder::addWeakBlock(int length)
 {
     // Flush out previous constant block.
-    addRawBit(1);
-    addRawBit(1);
+    m_encoder.add(0b11, 2);
 
     // Approximately 11 ambigious reversals per weak byte.
     length = length * 21 / 2;
 
+    auto& flux_times = m_encoder.flux_times();
     while (length-- > 0)
-        m_flux_times.push_back(m_bitcell_ns * 3 / 2);
+        flux_times.push_back(m_bitcell_ns * 3 / 2);
 }
 
 std::vector<uint32_t>& FluxTrackBuilder::buffer()
 {
     // Flush any buffered time with a transition.
-    if (m_flux_time)
-    {
-        m_flux_times.push_back(m_flux_time);
-        m_flux_time = 0;
-    }
-
-    return m_flux_times;
+    m_encoder.flush();
+    return m_encoder.flux_times();
 }
@@ -6,6 +6,7 @@
 #include "HDFHDD.h"
 
 #define SECTOR_BLOCK    2048    // access CF/HDD devices in 1MB chunks
+#define COPY_BLOCKS_IN_FLIGHT   4   // blocks read ahead of writing when copying
 
 
 /*static*/ bool HDD::IsRecognised(const std::string& path)
@@ -20,9 +21,12 @@
     std::shared_ptr<HDD> hdd;
 
     std::string open_path = path;
+    auto uncached = false;
 
     if (BlockDevice::IsBlockDevice(path))
     {
+        // Only devices are opened for direct I/O, as not all filesystems support it
+        uncached = opt.direct != 0;
 #ifdef _WIN32
         auto ulDevice = std::strtoul(path.c_str(), nullptr, 0);
         open_path = util::fmt(R"(\\.\PhysicalDrive%lu)", ulDevice);
@@ -34,7 +38,7 @@
     else if (HDFHDD::IsRecognised(path))
         hdd.reset(new HDFHDD());
 
-    if (hdd && !hdd->Open(open_path))
+    if (hdd && !hdd->Open(open_path, uncached))
         hdd.reset();
 
     return hdd;
@@ -215,55 +219,159 @@ bool HDD::SafetyCheck()
 
 bool HDD::Copy(HDD* phSrc_, int64_t uSectors_, int64_t uSrcOffset_/*=0*/, int64_t uDstOffset_/*=0*/, int64_t uTotal_/*=0*/, const char* pcszAction_)
 {
-    MEMORY mem(SECTOR_BLOCK * sector_size);
-
     if (!uTotal_) uTotal_ = uSectors_;
 
-    for (int64_t uPos = 0;;)
-    {
-        // Sync source and destinations
-        if (phSrc_) phSrc_->Seek(uSrcOffset_ + uPos);
-        Seek(uDstOffset_ + uPos);
-
-        // Determine how much to transfer in one go
-        if (uPos > uSectors_) uPos = uSectors_;
-        auto uBlock = std::min(static_cast<int>(uSectors_ - uPos), SECTOR_BLOCK);
+    // Transfer size, which can be overridden in KB
+    auto block_sectors = (opt.blocksize > 0) ? std::max(opt.blocksize * 1024 / sector_size, 1) : SECTOR_BLOCK;
 
+    auto show_progress = [&](int64_t uPos) {
         Message(msgStatus, "%s... %d%%", pcszAction_ ? pcszAction_ : "Copying",
             static_cast<int>((static_cast<uint64_t>(uDstOffset_ + uPos) * 100 / uTotal_)));
+    };
 
-        if (!uBlock)
-            break;
+    // Read a block from the source, returning the number of sectors to write.
+    // With no source the buffer is left as it is, which is zero-filled.
+    auto read_block = [&](uint8_t* pb, int64_t uPos) {
+        auto uBlock = static_cast<int>(std::min<int64_t>(uSectors_ - uPos, block_sectors));
+        if (!phSrc_)
+            return uBlock;
 
-        // Read from source disk
-        auto uRead = phSrc_ ? phSrc_->Read(mem, uBlock) : uBlock;
+        phSrc_->Seek(uSrcOffset_ + uPos);
+        auto uRead = phSrc_->Read(pb, uBlock);
         if (uRead != uBlock)
         {
             Message(msgStatus, "Read error at sector %lu: %s", uSrcOffset_ + uPos + uRead, LastError());
 
             // Clear the bad block, but include it in the read data
-            memset(mem + (uRead * sector_size), 0, sector_size);
+            memset(pb + (uRead * sector_size), 0, sector_size);
             ++uRead;
         }
 
         // Forced byte-swapping?
         if (opt.byteswap)
-            ByteSwap(mem, uRead * sector_size);
+            ByteSwap(pb, uRead * sector_size);
+
+        return uRead;
+    };
 
-        // Write to target disk
-        auto uWritten = Write(mem, uRead);
-        if (uWritten != uRead)
+    // Write a block to the target, skipping past any write errors.
+    auto write_block = [&](uint8_t* pb, int64_t uPos, int uCount) {
+        while (uCount > 0)
         {
-            Message(msgStatus, "Write error at sector %lu: %s", uDstOffset_ + uPos + uWritten, LastError());
+            Seek(uDstOffset_ + uPos);
+            auto uWritten = Write(pb, uCount);
+            if (uWritten != uCount)
+            {
+                Message(msgStatus, "Write error at sector %lu: %s", uDstOffset_ + uPos + uWritten, LastError());
+                ++uWritten;
+            }
+
+            pb += uWritten * sector_size;
+            uPos += uWritten;
+            uCount -= uWritten;
+        }
+    };
+
+    // Without a separate source to read, or with multi-threading disabled,
+    // each block is read and written in turn.
+    if (!phSrc_ || phSrc_ == this || !opt.mt)
+    {
+        MEMORY mem(block_sectors * sector_size);
 
-            // Skip past the write error
-            ++uWritten;
+        for (int64_t uPos = 0; uPos < uSectors_;)
+        {
+            show_progress(uPos);
+            auto uCount = read_block(mem, uPos);
+            write_block(mem, uPos, uCount);
+            uPos += uCount;
         }
 
-        // Advance by the amount written
-        uPos += uWritten;
+        show_progress(uSectors_);
+        return true;
+    }
+
+    // Otherwise the source is read ahead on a separate thread, so reads and
+    // writes overlap, with a few blocks in flight. The buffers are page
+    // aligned, as needed for devices opened for direct I/O.
+    struct CopyBlock
+    {
+        explicit CopyBlock(int size) : mem(size) {}
+        MEMORY mem;
+        int64_t pos = 0;
+        int sectors = 0;
+    };
+
+    std::vector<std::unique_ptr<CopyBlock>> blocks;
+    std::queue<CopyBlock*> free_blocks, full_blocks;
+    for (auto i = 0; i < COPY_BLOCKS_IN_FLIGHT; ++i)
+    {
+        blocks.push_back(std::make_unique<CopyBlock>(block_sectors * sector_size));
+        free_blocks.push(blocks.back().get());
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool stop = false;
+
+    std::thread reader([&]() {
+        for (int64_t uPos = 0; uPos < uSectors_;)
+        {
+            CopyBlock* block;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [&] { return stop || !free_blocks.empty(); });
+                if (stop)
+                    return;
+
+                block = free_blocks.front();
+                free_blocks.pop();
+            }
+
+            block->pos = uPos;
+            block->sectors = read_block(block->mem, uPos);
+            uPos += block->sectors;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            full_blocks.push(block);
+            cond.notify_all();
+        }
+        });
+
+    try
+    {
+        for (int64_t uPos = 0; uPos < uSectors_;)
+        {
+            show_progress(uPos);
+
+            CopyBlock* block;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [&] { return !full_blocks.empty(); });
+                block = full_blocks.front();
+                full_blocks.pop();
+            }
+
+            write_block(block->mem, block->pos, block->sectors);
+            uPos = block->pos + block->sectors;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            free_blocks.push(block);
+            cond.notify_all();
+        }
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cond.notify_all();
+        reader.join();
+        throw;
     }
 
+    reader.join();
+    show_progress(uSectors_);
     return true;
 }
 
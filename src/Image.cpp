@@ -8,6 +8,87 @@
 
 bool UnwrapSDF(std::shared_ptr<Disk>& src_disk, std::shared_ptr<Disk>& disk);
 
+namespace
+{
+
+struct ImageProbe
+{
+    IMAGE_READFUNC pfnRead = nullptr;
+    std::vector<const IMAGE_SIGNATURE*> signatures{};
+
+    bool matches(const MemFile& file) const
+    {
+        if (signatures.empty())
+            return true;
+
+        for (auto sig : signatures)
+        {
+            if (static_cast<size_t>(file.size()) >= sig->offset + sig->len &&
+                !memcmp(file.bytes() + sig->offset, sig->pszSignature, sig->len))
+                return true;
+        }
+
+        return false;
+    }
+};
+
+// Readers to offer an image, indexed by its first byte, in aImageTypes order.
+// Types with only leading signatures are listed under just those first bytes,
+// the rest under every byte. The final list is for empty files.
+class ProbeIndex
+{
+public:
+    static const ProbeIndex& get()
+    {
+        static const ProbeIndex index;
+        return index;
+    }
+
+    const std::vector<ImageProbe>& candidates(const MemFile& file) const
+    {
+        return file.size() ? m_by_first_byte[file.bytes()[0]] : m_by_first_byte[256];
+    }
+
+private:
+    ProbeIndex()
+    {
+        for (auto p = aImageTypes; p->pszType; ++p)
+        {
+            if (!p->pfnRead)
+                continue;
+
+            ImageProbe probe;
+            probe.pfnRead = p->pfnRead;
+
+            std::bitset<257> first_bytes;
+            for (auto sig = aImageSignatures; sig->pfnRead; ++sig)
+            {
+                if (sig->pfnRead != p->pfnRead)
+                    continue;
+
+                probe.signatures.push_back(sig);
+                if (sig->offset == 0)
+                    first_bytes.set(static_cast<uint8_t>(sig->pszSignature[0]));
+                else
+                    first_bytes.set().reset(256);
+            }
+
+            if (probe.signatures.empty())
+                first_bytes.set();
+
+            for (size_t i = 0; i < m_by_first_byte.size(); ++i)
+            {
+                if (first_bytes[i])
+                    m_by_first_byte[i].push_back(probe);
+            }
+        }
+    }
+
+    std::array<std::vector<ImageProbe>, 257> m_by_first_byte{};
+};
+
+} // namespace
+
 bool ReadImage(const std::string& path, std::shared_ptr<Disk>& disk, bool normalise)
 {
     MemFile file;
@@ -31,10 +112,15 @@ bool ReadImage(const std::string& path, std::shared_ptr<Disk>& disk, bool normal
         if (!file.open(path, !opt.nozip))
             return false;
 
-        // Present the image to all types with read support
-        for (auto p = aImageTypes; !f && p->pszType; ++p)
+        // Present the image to the types that could accept it, in table order.
+        // Signatures rule out most types, leaving those identified by fields or size.
+        for (auto& probe : ProbeIndex::get().candidates(file))
         {
-            if (p->pfnRead) f = p->pfnRead(file, disk);
+            if (probe.matches(file) && probe.pfnRead(file, disk))
+            {
+                f = true;
+                break;
+            }
         }
 
         // Store the archive type the image was found in, if any
@@ -172,13 +172,14 @@ int KryoFlux::GetInfo(int index, std::string& info)
 }
 
 
-void KryoFlux::ReadFlux(int revs, FluxData& flux_revs, std::vector<std::string>& warnings)
+void KryoFlux::ReadFlux(int revs, const std::function<void(std::vector<uint32_t>&& flux_times)>& on_rev,
+    std::vector<std::string>& warnings)
 {
     revs = std::max(1, std::min(revs, 20));
 
-    Data track_data;
-    track_data.reserve(1'000'000);
+    KFStreamDecoder decoder;
     Data chunk(0x10000);
+    auto rev_count = 0;
 
     // Start reading before we ask for the bulk data.
     StartAsyncRead();
@@ -188,12 +189,22 @@ void KryoFlux::ReadFlux(int revs, FluxData& flux_revs, std::vector<std::string>&
 
     for (;;)
     {
+        // Decode each chunk as it arrives, passing on completed revolutions
+        // while the device carries on streaming the next.
         auto len = ReadAsync(chunk.data(), chunk.size());
-        track_data.insert(track_data.end(), chunk.begin(), chunk.begin() + len);
+        decoder.add(chunk.data(), len);
 
-        // Check for end marker at end of current packet.
-        // ToDo: parse this properly, due to small risk of false positives.
-        if (len >= 7 && !memcmp(chunk.data() + len - 7, "\xd\xd\xd\xd\xd\xd\xd", 7))
+        std::vector<uint32_t> flux_times;
+        while (decoder.next_rev(flux_times))
+        {
+            on_rev(std::move(flux_times));
+            ++rev_count;
+        }
+
+        // Stop at the EOF block, or the end marker at the end of the current
+        // packet, in case the stream couldn't be parsed that far.
+        if (decoder.eof() ||
+            (len >= 7 && !memcmp(chunk.data() + len - 7, "\xd\xd\xd\xd\xd\xd\xd", 7)))
         {
             // Stop streaming and finish
             Control(REQ_STREAM, 0);
@@ -202,173 +213,267 @@ void KryoFlux::ReadFlux(int revs, FluxData& flux_revs, std::vector<std::string>&
         }
     }
 
-    // Decode the track data to multiple flux revolutions, plus any warnings
-    flux_revs = DecodeStream(track_data, warnings);
+    // Add any remaining revolutions, plus any warnings
+    for (auto& flux_times : decoder.finish(warnings))
+    {
+        on_rev(std::move(flux_times));
+        ++rev_count;
+    }
+
+    if (!rev_count)
+        warnings.push_back("no flux data");
+}
+
+/*static*/ FluxData KryoFlux::DecodeStream(const uint8_t* pb, int len, std::vector<std::string>& warnings)
+{
+    // Feed the decoder in USB-sized slices, as for a live read.
+    KFStreamDecoder decoder;
+    for (auto offset = 0; offset < len; offset += 0x10000)
+        decoder.add(pb + offset, std::min(len - offset, 0x10000));
+
+    auto flux_revs = decoder.finish(warnings);
+    if (flux_revs.empty())
+        warnings.push_back("no flux data");
+
+    return flux_revs;
+}
+
+
+KFStreamDecoder::KFStreamDecoder()
+    : m_ps_per_tick(PS_PER_TICK(SAMPLE_FREQ))
+{
+}
+
+bool KFStreamDecoder::eof() const
+{
+    return m_eof;
+}
+
+void KFStreamDecoder::add(const uint8_t* data, int len)
+{
+    if (m_eof)
+        return;
+
+    // Blocks may be split across chunks, so decode from any unused tail.
+    m_pending.insert(m_pending.end(), data, data + len);
+
+    auto p = m_pending.data();
+    auto avail = static_cast<int>(m_pending.size());
+    auto used = 0;
+
+    while (!m_eof && used < avail)
+    {
+        auto block_len = decode_block(p + used, avail - used);
+        if (!block_len)
+            break;
+
+        used += block_len;
+    }
+
+    m_pending.erase(m_pending.begin(), m_pending.begin() + used);
+    end_revs(false);
 }
 
+bool KFStreamDecoder::next_rev(std::vector<uint32_t>& flux_times)
+{
+    if (m_revs.empty())
+        return false;
+
+    flux_times = std::move(m_revs.front());
+    m_revs.pop_front();
+    return true;
+}
 
-/*static*/ FluxData KryoFlux::DecodeStream(const Data& data, std::vector<std::string>& warnings)
+FluxData KFStreamDecoder::finish(std::vector<std::string>& warnings)
 {
+    end_revs(true);
+
     FluxData flux_revs;
-    std::vector<uint32_t> flux_times, flux_counts;
-    flux_times.reserve(data.size());
-    flux_counts.resize(data.size());
+    while (!m_revs.empty())
+    {
+        flux_revs.push_back(std::move(m_revs.front()));
+        m_revs.pop_front();
+    }
 
-    uint32_t time = 0, stream_pos = 0;
-    uint32_t ps_per_tick = PS_PER_TICK(SAMPLE_FREQ);
-    std::vector<uint32_t> index_offsets;
-    int hard_indexes = 0;
+    warnings.insert(warnings.end(), m_warnings.begin(), m_warnings.end());
+    m_warnings.clear();
+    return flux_revs;
+}
+
+// Decode a single block, returning its length, or 0 if it's incomplete.
+int KFStreamDecoder::decode_block(const uint8_t* p, int len)
+{
+    // Store current flux count at each stream position
+    if (m_flux_counts.size() <= m_stream_pos)
+        m_flux_counts.resize(m_stream_pos + 1);
+    m_flux_counts[m_stream_pos] = static_cast<uint32_t>(m_flux_times.size());
 
-    auto itBegin = data.begin(), it = itBegin, itEnd = data.end();
-    while (it != itEnd)
+    auto type = p[0];
+    switch (type)
     {
-        // Store current flux count at each stream position
-        flux_counts[stream_pos] = static_cast<int>(flux_times.size());
+    case 0x0c: // Flux3
+        if (len < 3)
+            return 0;
+        m_time += (static_cast<uint32_t>(p[1]) << 8) | p[2];
+        m_flux_times.push_back(m_time * m_ps_per_tick / 1000);
+        m_stream_pos += 3;
+        m_time = 0;
+        return 3;
+
+    case 0x00: case 0x01: case 0x02: case 0x03: // Flux 2
+    case 0x04: case 0x05: case 0x06: case 0x07:
+        if (len < 2)
+            return 0;
+        m_time += (static_cast<uint32_t>(type) << 8) | p[1];
+        m_flux_times.push_back(m_time * m_ps_per_tick / 1000);
+        m_stream_pos += 2;
+        m_time = 0;
+        return 2;
+
+    case 0x8:   // Nop1
+    case 0x9:   // Nop2
+    case 0xa:   // Nop3
+    {
+        auto nop_len = type - 0x8 + 1;
+        if (len < nop_len)
+            return 0;
+        m_stream_pos += nop_len;
+        return nop_len;
+    }
 
-        auto type = *it++;
-        switch (type)
+    case 0xb:   // Ovl16
+        m_time += 0x10000;
+        m_stream_pos++;
+        return 1;
+
+    case KryoFlux::OOB:
+    {
+        if (len < 4)
+            return 0;
+
+        auto subtype = p[1];
+        auto size = static_cast<int>(p[2] | (p[3] << 8));
+
+        // EOF has a fake size, and bad blocks end decoding, so neither need data.
+        if (subtype == 0x0d || subtype == 0x00 || subtype > 0x04)
+            size = 0;
+        else if (len < 4 + size)
+            return 0;
+
+        auto pdw = reinterpret_cast<const uint32_t*>(p + 4);
+
+        switch (subtype)
         {
-        case 0x0c: // Flux3
-            type = *it++;
-            stream_pos++;
-        case 0x00: case 0x01: case 0x02: case 0x03: // Flux 2
-        case 0x04: case 0x05: case 0x06: case 0x07:
-            time += (static_cast<uint32_t>(type) << 8) | *it++;
-            flux_times.push_back(time * ps_per_tick / 1000);
-            stream_pos += 2;
-            time = 0;
+        case 0x00:  // Invalid
+            m_warnings.push_back("invalid OOB detected");
+            m_eof = true;
             break;
-        case 0xa:   // Nop3
-            it++;
-            stream_pos++;
-        case 0x9:   // Nop2
-            it++;
-            stream_pos++;
-        case 0x8:   // Nop1
-            stream_pos++;
+
+        case 0x01:  // StreamInfo
+            assert(size == 8);
             break;
-        case 0xb:   // Ovl16
-            time += 0x10000;
-            stream_pos++;
+
+        case 0x02:  // Index
+            assert(size == 12);
+
+            // Soft-sectored disks have a single start-of-track index.
+            // Hard-sectors are combined to achieve the same result.
+            if (opt.hardsectors <= 1 || !(++m_hard_indexes % opt.hardsectors))
+                m_index_offsets.push_back(util::letoh(pdw[0]));
             break;
 
-        case OOB:   // OOB
+        case 0x03:  // StreamEnd
         {
-            auto subtype = *it++;
-            uint16_t size = *it++;
-            size |= (*it++ << 8);
+            assert(size == 8);
 
-            switch (subtype)
-            {
-            case 0x00:  // Invalid
-                warnings.push_back("invalid OOB detected");
-                it = itEnd;
-                break;
+            //                      auto eof_pos = util::letoh(pdw[0]);
+            auto eof_ret = util::letoh(pdw[1]);
 
-            case 0x01:  // StreamInfo
-                assert(size == 8);
-                break;
+            if (eof_ret == 1)
+                m_warnings.push_back("stream end (buffering problem)");
+            else if (eof_ret == 2)
+                m_warnings.push_back("stream end (no index detected)");
+            else if (eof_ret != 0)
+                m_warnings.push_back(util::fmt("stream end problem (%u)", eof_ret));
+            break;
+        }
 
-            case 0x02:  // Index
+        case 0x04:  // KFInfo
+        {
+            auto pinfo = reinterpret_cast<const char*>(p + 4);
+            std::string info(pinfo, std::find(pinfo, pinfo + size, '\0'));
+            for (auto& entry : util::split(info, ','))
             {
-                assert(size == 12);
-
-                // Soft-sectored disks have a single start-of-track index.
-                // Hard-sectors are combined to achieve the same result.
-                if (opt.hardsectors <= 1 || !(++hard_indexes % opt.hardsectors))
+                auto pos = entry.find('=');
+                if (pos != entry.npos)
                 {
-                    auto pdw = reinterpret_cast<const uint32_t*>(&*it);
-                    index_offsets.push_back(util::letoh(pdw[0]));
-                }
-                break;
-            }
+                    auto name = util::trim(entry.substr(0, pos));
+                    auto value = util::trim(entry.substr(pos + 1));
 
-            case 0x03:  // StreamEnd
-            {
-                assert(size == 8);
-
-                auto pdw = reinterpret_cast<const uint32_t*>(&*it);
-                //                      auto eof_pos = util::letoh(pdw[0]);
-                auto eof_ret = util::letoh(pdw[1]);
-
-                if (eof_ret == 1)
-                    warnings.push_back("stream end (buffering problem)");
-                else if (eof_ret == 2)
-                    warnings.push_back("stream end (no index detected)");
-                else if (eof_ret != 0)
-                    warnings.push_back(util::fmt("stream end problem (%u)", eof_ret));
-                break;
-            }
-
-            case 0x04:  // KFInfo
-            {
-                std::string info = reinterpret_cast<const char*>(&*it);
-                for (auto& entry : util::split(info, ','))
-                {
-                    auto pos = entry.find('=');
-                    if (pos != entry.npos)
+                    if (!name.empty() && !value.empty())
                     {
-                        auto name = util::trim(entry.substr(0, pos));
-                        auto value = util::trim(entry.substr(pos + 1));
-
-                        if (!name.empty() && !value.empty())
-                        {
-                            //                                  disk.metadata[name] = value;
+                        //                                  disk.metadata[name] = value;
 
-                            if (name == "sck")
-                                ps_per_tick = PS_PER_TICK(std::atoi(value.c_str()));
-                        }
+                        if (name == "sck")
+                            m_ps_per_tick = PS_PER_TICK(std::atoi(value.c_str()));
                     }
                 }
-                break;
             }
-
-            case 0x0d:  // EOF
-                assert(size == 0x0d0d);     // documented value
-                size = 0;                   // size is fake, so clear it
-                it = itEnd;                 // advance to end
-                break;
-
-            default:
-                warnings.push_back(util::fmt("unexpected OOB sub-type (%X)", subtype));
-                it = itEnd;
-                break;
-            }
-
-            it += size;
             break;
         }
 
-        default:    // Flux1
-            time += type;
-            flux_times.push_back(time * ps_per_tick / 1000);
-            stream_pos++;
-            time = 0;
+        case 0x0d:  // EOF
+            assert((p[2] | (p[3] << 8)) == 0x0d0d);     // documented value
+            m_eof = true;
+            break;
+
+        default:
+            m_warnings.push_back(util::fmt("unexpected OOB sub-type (%X)", subtype));
+            m_eof = true;
             break;
         }
+
+        return 4 + size;
     }
 
-    uint32_t last_pos = 0;
-    for (auto index_offset : index_offsets)
+    default:    // Flux1
+        m_time += type;
+        m_flux_times.push_back(m_time * m_ps_per_tick / 1000);
+        m_stream_pos++;
+        m_time = 0;
+        return 1;
+    }
+}
+
+// Split off revolutions ending at index positions already decoded, or all
+// remaining indexes at the end of the stream.
+void KFStreamDecoder::end_revs(bool at_end)
+{
+    while (!m_index_offsets.empty() && (at_end || m_index_offsets.front() < m_stream_pos))
     {
+        auto index_offset = m_index_offsets.front();
+        m_index_offsets.pop_front();
+
         // Ignore first partial track
-        if (last_pos != 0)
+        if (m_last_pos != 0)
         {
             // Find the most recent flux count.
-            while (index_offset && !flux_counts[index_offset])
+            while (index_offset && (index_offset >= m_flux_counts.size() || !m_flux_counts[index_offset]))
                 --index_offset;
 
+            auto flux_count = m_flux_counts.empty() ? 0 : m_flux_counts[index_offset];
+
             // Extract flux segment for current revolution
-            flux_revs.emplace_back(std::vector<uint32_t>(
-                flux_times.begin() + last_pos,
-                flux_times.begin() + flux_counts[index_offset]));
-        }
+            m_revs.emplace_back(std::vector<uint32_t>(
+                m_flux_times.begin() + m_last_pos,
+                m_flux_times.begin() + flux_count));
 
-        last_pos = flux_counts[index_offset];
+            m_last_pos = flux_count;
+        }
+        else
+        {
+            // The first index starts from the count at its own position.
+            m_last_pos = (index_offset < m_flux_counts.size()) ? m_flux_counts[index_offset] : 0;
+        }
     }
-
-    if (flux_revs.size() == 0)
-        warnings.push_back("no flux data");
-
-    return flux_revs;
 }
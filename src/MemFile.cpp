@@ -17,6 +17,10 @@
 #include <lzma.h>
 #endif
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 std::string to_string(const Compress& compression)
 {
     switch (compression)
@@ -31,160 +35,331 @@ std::string to_string(const Compress& compression)
 }
 
 
-bool MemFile::open(const std::string& path_, bool uncompress)
+// MemFile offsets are ints, which is the only limit on decompressed size.
+static constexpr size_t MAX_MEMFILE_SIZE = std::numeric_limits<int>::max();
+
+// Check for the signatures of the compressed formats we handle below.
+static bool is_compressed(const uint8_t* pb, int size)
 {
-    std::string filename;
-    MEMORY mem(MAX_IMAGE_SIZE + 1);
-    size_t uRead = 0;
+    if (size >= 2 && ((pb[0] == 'P' && pb[1] == 'K') ||
+        (pb[0] == 0x1f && pb[1] == 0x8b) || (pb[0] == 'B' && pb[1] == 'Z')))
+        return true;
 
-    // Check if zlib is available
-#ifndef HAVE_ZLIB
-    bool have_zlib = false;
-#else
-    bool have_zlib = zlibVersion()[0] == ZLIB_VERSION[0];
+    return size > 6 && !memcmp(pb, "\xfd\x37\x7a\x58\x5a\x00", 6);
+}
+
+// Grow a streaming output buffer geometrically, returning the free space,
+// which never exceeds MAX_MEMFILE_SIZE so fits the decoders' 32-bit counts.
+static size_t grow_output(Data& data, size_t used)
+{
+    if (used < static_cast<size_t>(data.size()))
+        return static_cast<size_t>(data.size()) - used;
+
+    auto new_size = std::min(std::max(used * 2, static_cast<size_t>(0x100000)), MAX_MEMFILE_SIZE);
+    if (new_size <= used)
+        throw util::exception("file size too big");
+
+    data.resize(new_size);
+    return new_size - used;
+}
+
+#ifdef HAVE_ZLIB
+static Data gunzip(const uint8_t* pb, size_t len, std::string& filename)
+{
+    Data data;
+    size_t used = 0;
+
+    Bytef name[MAX_PATH]{};
+    gz_header header{};
+    header.name = name;
+    header.name_max = MAX_PATH;
+
+    z_stream stream{};
+    stream.next_in = const_cast<Bytef*>(pb);
+    stream.avail_in = static_cast<uInt>(len);
 
-    // Read start of file to check for compression signatures.
-    if (uncompress && have_zlib)
+    auto zerr = inflateInit2(&stream, 16 + MAX_WBITS); // 16=gzip
+    if (zerr == Z_OK)
+        zerr = inflateGetHeader(&stream, &header);
+
+    while (zerr == Z_OK)
     {
-        FILE* f = fopen(path_.c_str(), "rb");
-        if (!f)
-            throw posix_error(errno, path_.c_str());
+        auto avail = grow_output(data, used);
+        stream.next_out = data.data() + used;
+        stream.avail_out = static_cast<uInt>(avail);
 
-        if (!fread(mem, 1, 2, f))
-            mem[0] = mem[1] = '\0';
+        zerr = inflate(&stream, Z_NO_FLUSH);
+        used = stream.next_out - data.data();
 
-        fclose(f);
+        // Continue into any further members, as gzread() would.
+        if (zerr == Z_STREAM_END && stream.avail_in >= 2 &&
+            stream.next_in[0] == 0x1f && stream.next_in[1] == 0x8b)
+            zerr = inflateReset(&stream);
     }
 
-    if (uncompress && have_zlib)
+    inflateEnd(&stream);
+
+    // Keep what we have of a truncated file, which may still be usable.
+    if (zerr == Z_BUF_ERROR && !stream.avail_in && used)
+        Message(msgWarning, "gzip file is truncated");
+    else if (zerr != Z_STREAM_END)
+        throw util::exception("gzip decompression failed (", zerr, ")");
+
+    if (name[0])
+        filename = reinterpret_cast<const char*>(name);
+
+    data.resize(used);
+    return data;
+}
+
+// Read the current zip member, sized up front from its directory entry. The
+// entry isn't trusted beyond a small multiple of the compressed size, so a
+// corrupt one can't force a huge allocation, and the buffer grows past that.
+static int unzip_current(unzFile hfZip, const unz_file_info& info, Data& data)
+{
+    constexpr uint64_t MAX_RESERVE_RATIO = 8;
+    auto reserve = std::min(static_cast<uint64_t>(info.uncompressed_size),
+        static_cast<uint64_t>(info.compressed_size) * MAX_RESERVE_RATIO + 0x10000);
+
+    size_t used = 0;
+    data.resize(static_cast<size_t>(std::min(reserve, static_cast<uint64_t>(MAX_MEMFILE_SIZE))));
+
+    for (;;)
     {
-        // Require zip file header magic.
-        if (mem[0U] == 'P' && mem[1U] == 'K')
-        {
-            unzFile hfZip = unzOpen(path_.c_str());
-            if (!hfZip)
-                throw util::exception("bad zip file");
+        if (used == static_cast<size_t>(data.size()) && unzeof(hfZip))
+            break;
 
-            int nRet;
-            unz_file_info sInfo;
-            uLong ulMaxSize = 0;
+        auto avail = grow_output(data, used);
+        auto nRet = unzReadCurrentFile(hfZip, data.data() + used, static_cast<unsigned>(avail));
+        if (nRet < 0)
+            return nRet;
+        else if (!nRet)
+            break;
 
-            // Iterate through the contents of the zip looking for a file with a suitable size
-            for (nRet = unzGoToFirstFile(hfZip); nRet == UNZ_OK; nRet = unzGoToNextFile(hfZip))
-            {
-                char szFile[MAX_PATH];
-
-                // Get details of the current file
-                unzGetCurrentFileInfo(hfZip, &sInfo, szFile, MAX_PATH, nullptr, 0, nullptr, 0);
-
-                // Ignore directories and empty files
-                if (!sInfo.uncompressed_size)
-                    continue;
-
-                // If the file extension is recognised, read the file contents
-                // ToDo: GetFileType doesn't really belong here?
-                if (GetFileType(szFile) != ftUnknown && unzOpenCurrentFile(hfZip) == UNZ_OK)
-                {
-                    nRet = unzReadCurrentFile(hfZip, mem, static_cast<unsigned int>(mem.size));
-                    unzCloseCurrentFile(hfZip);
-                    filename = szFile;
-                    break;
-                }
-
-                // Rememeber the largest uncompressed file size
-                if (sInfo.uncompressed_size > ulMaxSize)
-                    ulMaxSize = sInfo.uncompressed_size;
-            }
+        used += nRet;
+    }
 
-            // Did we fail to find a matching extension?
-            if (nRet == UNZ_END_OF_LIST_OF_FILE)
-            {
-                // Loop back over the archive
-                for (nRet = unzGoToFirstFile(hfZip); nRet == UNZ_OK; nRet = unzGoToNextFile(hfZip))
-                {
-                    // Get details of the current file
-                    unzGetCurrentFileInfo(hfZip, &sInfo, nullptr, 0, nullptr, 0, nullptr, 0);
-
-                    // Open the largest file found about
-                    if (sInfo.uncompressed_size == ulMaxSize && unzOpenCurrentFile(hfZip) == UNZ_OK)
-                    {
-                        nRet = unzReadCurrentFile(hfZip, mem, static_cast<unsigned int>(mem.size));
-                        unzCloseCurrentFile(hfZip);
-                        break;
-                    }
-                }
-            }
+    data.resize(used);
+    return UNZ_OK;
+}
 
-            // Close the zip archive
-            unzClose(hfZip);
+static Data unzip(const std::string& path, std::string& filename)
+{
+    unzFile hfZip = unzOpen(path.c_str());
+    if (!hfZip)
+        throw util::exception("bad zip file");
 
-            if (nRet < 0)
-                throw util::exception("zip extraction failed (", nRet, ")");
+    Data data;
+    int nRet;
+    unz_file_info sInfo;
+    uLong ulMaxSize = 0;
 
-            uRead = nRet;
-            m_compress = Compress::Zip;
-        }
-        // Require gzip file header magic.
-        else if (mem[0U] == 0x1f && mem[1U] == 0x8b)
+    // Iterate through the contents of the zip looking for a file with a suitable size
+    for (nRet = unzGoToFirstFile(hfZip); nRet == UNZ_OK; nRet = unzGoToNextFile(hfZip))
+    {
+        char szFile[MAX_PATH];
+
+        // Get details of the current file
+        unzGetCurrentFileInfo(hfZip, &sInfo, szFile, MAX_PATH, nullptr, 0, nullptr, 0);
+
+        // Ignore directories and empty files
+        if (!sInfo.uncompressed_size)
+            continue;
+
+        // If the file extension is recognised, read the file contents
+        // ToDo: GetFileType doesn't really belong here?
+        if (GetFileType(szFile) != ftUnknown && unzOpenCurrentFile(hfZip) == UNZ_OK)
         {
-            // Open as gzipped or uncompressed
-            gzFile gf = gzopen(path_.c_str(), "rb");
-            if (gf == Z_NULL)
-                throw posix_error(errno, path_.c_str());
+            nRet = unzip_current(hfZip, sInfo, data);
+            unzCloseCurrentFile(hfZip);
+            filename = szFile;
+            break;
+        }
 
-            uRead = gzread(gf, mem, static_cast<unsigned>(mem.size));
-            m_compress = gzdirect(gf) ? Compress::None : Compress::Gzip;
-            gzclose(gf);
+        // Rememeber the largest uncompressed file size
+        if (sInfo.uncompressed_size > ulMaxSize)
+            ulMaxSize = sInfo.uncompressed_size;
+    }
 
-            // If gzipped, attempt to extract the original filename
-            if (m_compress == Compress::Gzip)
+    // Did we fail to find a matching extension?
+    if (nRet == UNZ_END_OF_LIST_OF_FILE)
+    {
+        // Loop back over the archive
+        for (nRet = unzGoToFirstFile(hfZip); nRet == UNZ_OK; nRet = unzGoToNextFile(hfZip))
+        {
+            // Get details of the current file
+            unzGetCurrentFileInfo(hfZip, &sInfo, nullptr, 0, nullptr, 0, nullptr, 0);
+
+            // Open the largest file found about
+            if (sInfo.uncompressed_size == ulMaxSize && unzOpenCurrentFile(hfZip) == UNZ_OK)
             {
-                std::ifstream zs(path_.c_str(), std::ios_base::binary);
-                std::vector<uint8_t> zbuf((std::istreambuf_iterator<char>(zs)),
-                    std::istreambuf_iterator<char>());
-
-                z_stream stream{};
-                stream.next_in = zbuf.data();
-                stream.avail_in = static_cast<uInt>(zbuf.size());
-                stream.next_out = zbuf.data();  // same as next_in!
-                stream.avail_out = 0;           // we don't want data
-
-                auto zerr = inflateInit2(&stream, 16 + MAX_WBITS); // 16=gzip
-                if (zerr == Z_OK)
-                {
-                    Bytef name[MAX_PATH]{};
-                    gz_header header{};
-                    header.name = name;
-                    header.name_max = MAX_PATH;
-
-                    zerr = inflateGetHeader(&stream, &header);
-                    zerr = inflate(&stream, 0);
-                    if (zerr == Z_OK && name[0])
-                        filename = reinterpret_cast<const char*>(name);
-                    inflateEnd(&stream);
-                }
+                nRet = unzip_current(hfZip, sInfo, data);
+                unzCloseCurrentFile(hfZip);
+                break;
             }
         }
     }
+
+    // Close the zip archive
+    unzClose(hfZip);
+
+    if (nRet < 0)
+        throw util::exception("zip extraction failed (", nRet, ")");
+
+    return data;
+}
 #endif // HAVE_ZLIB
 
-    // If didn't read as a compressed file, open as normal file.
-    if (!uRead)
+#ifdef HAVE_BZIP2
+static Data bunzip2(const uint8_t* pb, size_t len)
+{
+    Data data;
+    size_t used = 0;
+
+    bz_stream stream{};
+    stream.next_in = reinterpret_cast<char*>(const_cast<uint8_t*>(pb));
+    stream.avail_in = static_cast<unsigned>(len);
+
+    auto bzerr = BZ2_bzDecompressInit(&stream, 0, 0);
+    while (bzerr == BZ_OK)
+    {
+        auto avail = grow_output(data, used);
+        stream.next_out = reinterpret_cast<char*>(data.data() + used);
+        stream.avail_out = static_cast<unsigned>(avail);
+
+        bzerr = BZ2_bzDecompress(&stream);
+        used = reinterpret_cast<uint8_t*>(stream.next_out) - data.data();
+
+        // Input exhausted without reaching the end of the stream?
+        if (bzerr == BZ_OK && !stream.avail_in && stream.avail_out)
+            bzerr = BZ_UNEXPECTED_EOF;
+    }
+
+    BZ2_bzDecompressEnd(&stream);
+
+    if (bzerr != BZ_STREAM_END)
+        throw util::exception("bzip2 decompression failed (", bzerr, ")");
+
+    data.resize(used);
+    return data;
+}
+#endif // HAVE_BZIP2
+
+#ifdef HAVE_LZMA
+static Data unxz(const uint8_t* pb, size_t len)
+{
+    Data data;
+    size_t used = 0;
+
+    lzma_stream strm = LZMA_STREAM_INIT;
+    const uint32_t flags = LZMA_TELL_UNSUPPORTED_CHECK;
+    auto ret = lzma_stream_decoder(&strm, UINT64_MAX, flags);
+
+    strm.next_in = pb;
+    strm.avail_in = len;
+
+    while (ret == LZMA_OK)
+    {
+        strm.avail_out = grow_output(data, used);
+        strm.next_out = data.data() + used;
+
+        ret = lzma_code(&strm, LZMA_FINISH);
+        used = strm.next_out - data.data();
+    }
+
+    lzma_end(&strm);
+
+    if (ret != LZMA_STREAM_END)
+        throw util::exception("xz decompression failed (", ret, ")");
+
+    data.resize(used);
+    return data;
+}
+#endif // HAVE_LZMA
+
+
+bool MemFile::open(const std::string& path_, bool uncompress)
+{
+    // Serve uncompressed files straight from a read-only mapping, falling
+    // back on reading the file if it can't be mapped.
+    if (!open_mapped(path_))
+        open_read(path_);
+
+    std::string filename;
+    m_compress = Compress::None;
+
+    if (uncompress && is_compressed(m_pb, m_size))
+        decompress(path_, filename);
+
+    set_path(path_, filename);
+    return true;
+}
+
+void MemFile::open_read(const std::string& path_)
+{
+    FILE* f = fopen(path_.c_str(), "rb");
+    if (!f)
+        throw posix_error(errno, path_.c_str());
+
+    Data data;
+    size_t used = 0;
+    for (;;)
     {
-        FILE* f = fopen(path_.c_str(), "rb");
-        if (!f)
-            throw posix_error(errno, path_.c_str());
+        if (used == MAX_MEMFILE_SIZE)
+        {
+            fclose(f);
+            throw util::exception("file size too big");
+        }
+
+        auto avail = grow_output(data, used);
+        auto uRead = fread(data.data() + used, 1, avail, f);
+        used += uRead;
 
-        uRead = fread(mem, 1, mem.size, f);
-        fclose(f);
-        m_compress = Compress::None;
+        if (uRead != avail)
+            break;
     }
+    fclose(f);
+
+    data.resize(used);
+    m_data = std::make_shared<Data>(std::move(data));
+    m_pb = m_data->data();
+    m_size = m_data->size();
+}
+
+void MemFile::decompress(const std::string& path_, std::string& filename)
+{
+    auto start_time = std::chrono::steady_clock::now();
+    auto compressed_size = m_size;
+
+    auto adopt = [&](Data&& data, Compress compress) {
+        m_mapping.reset();
+        m_data = std::make_shared<Data>(std::move(data));
+        m_pb = m_data->data();
+        m_size = m_data->size();
+        m_compress = compress;
+    };
+
+    auto is_gzip = [&] { return m_size >= 2 && m_pb[0] == 0x1f && m_pb[1] == 0x8b; };
+
+    // Check if zlib is available
+#ifndef HAVE_ZLIB
+    bool have_zlib = false;
+    (void)path_;
+#else
+    bool have_zlib = zlibVersion()[0] == ZLIB_VERSION[0];
+
+    if (have_zlib && m_size >= 2 && m_pb[0] == 'P' && m_pb[1] == 'K')
+        adopt(unzip(path_, filename), Compress::Zip);
+    else if (have_zlib && is_gzip())
+        adopt(gunzip(m_pb, m_size, filename), Compress::Gzip);
+#endif
 
     // zip compressed? (and not handled above)
-    if (uncompress && mem[0U] == 'P' && mem[1U] == 'K')
+    if (m_compress == Compress::None && m_size >= 2 && m_pb[0] == 'P' && m_pb[1] == 'K')
         throw util::exception("zlib support is not available for zipped files");
+
     // gzip compressed?
-    if (uncompress && mem[0U] == 0x1f && mem[1U] == 0x8b)
+    if (is_gzip())
     {
         if (!have_zlib)
             throw util::exception("zlib support is not available for gzipped files");
@@ -192,101 +367,114 @@ bool MemFile::open(const std::string& path_, bool uncompress)
         // Unknowingly gzipped image files may be zipped, so we need to handle
         // a second level of decompression here.
 #ifdef HAVE_ZLIB
-        MEMORY mem2(MAX_IMAGE_SIZE + 1);
-
-        z_stream stream{};
-        stream.next_in = mem.pb;
-        stream.avail_in = static_cast<uInt>(uRead);
-        stream.next_out = mem2.pb;
-        stream.avail_out = static_cast<uInt>(mem2.size);
-
-        auto zerr = inflateInit2(&stream, 16 + MAX_WBITS);
-        if (zerr == Z_OK)
-        {
-            Bytef name[MAX_PATH]{};
-            gz_header header{};
-            header.name = name;
-            header.name_max = MAX_PATH;
-
-            zerr = inflateGetHeader(&stream, &header);
-            zerr = inflate(&stream, Z_FINISH);
-            if (zerr == Z_STREAM_END && name[0])
-                filename = reinterpret_cast<const char*>(name);
-            inflateEnd(&stream);
-        }
-
-        if (zerr != Z_STREAM_END)
-            throw util::exception("gzip decompression failed (", zerr, ")");
-
-        memcpy(mem.pb, mem2.pb, uRead = stream.total_out);
-        m_compress = Compress::Zip;
+        adopt(gunzip(m_pb, m_size, filename), Compress::Zip);
 #endif
     }
 
     // bzip2 compressed?
-    if (uncompress && mem[0U] == 'B' && mem[1U] == 'Z')
+    if (m_size >= 2 && m_pb[0] == 'B' && m_pb[1] == 'Z')
     {
 #ifndef HAVE_BZIP2
         throw util::exception("bzip2 support is not available");
 #else
-        MEMORY mem2(MAX_IMAGE_SIZE + 1);
-
-        auto uBzRead = static_cast<unsigned>(mem2.size);
-        auto bzerr = BZ2_bzBuffToBuffDecompress(
-            reinterpret_cast<char*>(mem2.pb), &uBzRead,
-            reinterpret_cast<char*>(mem.pb), static_cast<int>(uRead), 0, 0);
-        if (bzerr != BZ_OK)
-            throw util::exception("bzip2 decompression failed (", bzerr, ")");
-
-        memcpy(mem.pb, mem2.pb, uRead = uBzRead);
-        m_compress = Compress::Bzip2;
-#endif // HAVE_BZIP2
+        adopt(bunzip2(m_pb, m_size), Compress::Bzip2);
+#endif
     }
 
-    if (uncompress && mem.size > 6 && !memcmp(mem.pb, "\xfd\x37\x7a\x58\x5a\x00", 6))
+    if (m_size > 6 && !memcmp(m_pb, "\xfd\x37\x7a\x58\x5a\x00", 6))
     {
 #ifndef HAVE_LZMA
         throw util::exception("lzma support is not available");
 #else
-        MEMORY mem2(MAX_IMAGE_SIZE + 1);
-
-        lzma_stream strm{};
-        const uint32_t flags = LZMA_TELL_UNSUPPORTED_CHECK;
-        auto ret = lzma_stream_decoder(&strm, UINT64_MAX, flags);
-        if (ret == LZMA_OK)
-        {
-            strm.next_in = mem.pb;
-            strm.avail_in = mem.size;
-            strm.next_out = mem2.pb;
-            strm.avail_out = mem2.size;
-
-            ret = lzma_code(&strm, LZMA_FINISH);
-            if (ret == LZMA_STREAM_END)
-            {
-                uRead = mem2.size - strm.avail_out;
-                memcpy(mem.pb, mem2.pb, uRead);
-                m_compress = Compress::Xz;
-                ret = LZMA_OK;
-            }
-        }
-
-        if (ret != LZMA_OK)
-            throw util::exception("xz decompression failed (", ret, ")");
+        adopt(unxz(m_pb, m_size), Compress::Xz);
 #endif
     }
 
-    if (uRead <= MAX_IMAGE_SIZE)
-        return open(mem.pb, static_cast<int>(uRead), path_, filename);
-
-    throw util::exception("file size too big");
+    if (opt.time)
+    {
+        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+        util::cout << "Decompressed " << to_string(m_compress) << ": " << compressed_size <<
+            " -> " << m_size << " bytes in " << elapsed_ms << "ms";
+        if (elapsed_ms)
+            util::cout << " (" << (m_size / 1000 / elapsed_ms) << " MB/s)";
+        util::cout << "\n";
+    }
 }
 
 bool MemFile::open(const void* buf, int len, const std::string& path_, const std::string& filename_)
 {
     auto pb = reinterpret_cast<const uint8_t*>(buf);
 
-    m_data.clear();
-    m_it = m_data.insert(m_data.begin(), pb, pb + len);
+    m_mapping.reset();
+    m_data = std::make_shared<Data>(pb, pb + len);
+    m_pb = m_data->data();
+    m_size = len;
+    m_pos = 0;
+    set_path(path_, filename_);
+
+    return true;
+}
+
+bool MemFile::open_mapped(const std::string& path_)
+{
+    m_mapping.reset();
+    m_data.reset();
+    m_pb = nullptr;
+    m_size = m_pos = 0;
+
+#if defined(_WIN32)
+    HANDLE hfile = CreateFile(path_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hfile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size{};
+    HANDLE hmap = nullptr;
+    if (GetFileSizeEx(hfile, &file_size) && file_size.QuadPart > 0 && file_size.QuadPart <= static_cast<LONGLONG>(MAX_MEMFILE_SIZE))
+        hmap = CreateFileMapping(hfile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(hfile);
+
+    if (!hmap)
+        return false;
+
+    auto pv = MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(hmap);
+
+    if (!pv)
+        return false;
+
+    m_mapping = std::shared_ptr<const uint8_t>(static_cast<const uint8_t*>(pv),
+        [](const uint8_t* pb) { UnmapViewOfFile(pb); });
+    m_size = static_cast<int>(file_size.QuadPart);
+#elif defined(HAVE_SYS_MMAN_H)
+    auto fd = ::open(path_.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st {};
+    void* pv = MAP_FAILED;
+    if (!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0 && static_cast<size_t>(st.st_size) <= MAX_MEMFILE_SIZE)
+        pv = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (pv == MAP_FAILED)
+        return false;
+
+    auto len = static_cast<size_t>(st.st_size);
+    m_mapping = std::shared_ptr<const uint8_t>(static_cast<const uint8_t*>(pv),
+        [len](const uint8_t* pb) { munmap(const_cast<uint8_t*>(pb), len); });
+    m_size = static_cast<int>(len);
+#else
+    (void)path_;
+    return false;
+#endif
+
+    m_pb = m_mapping.get();
+    return true;
+}
+
+void MemFile::set_path(const std::string& path_, const std::string& filename_)
+{
     m_path = path_;
     m_filename = filename_;
 
@@ -302,24 +490,31 @@ bool MemFile::open(const void* buf, int len, const std::string& path_, const std
         else if (IsFileExt(m_filename, "bz2"))
             m_filename = m_filename.substr(0, m_filename.size() - 4);
     }
-
-    return true;
 }
 
 
 const Data& MemFile::data() const
 {
-    return m_data;
+    // Mapped files are copied on first use, for callers needing a container.
+    if (!m_data)
+        m_data = std::make_shared<Data>(m_pb, m_pb + m_size);
+
+    return *m_data;
+}
+
+const uint8_t* MemFile::bytes() const
+{
+    return m_pb;
 }
 
 int MemFile::size() const
 {
-    return static_cast<int>(m_data.size());
+    return m_size;
 }
 
 int MemFile::remaining() const
 {
-    return static_cast<int>(m_data.end() - m_it);
+    return m_size - m_pos;
 }
 
 const std::string& MemFile::path() const
@@ -342,15 +537,15 @@ bool MemFile::read(uint8_t& b)
     if (remaining() < 1)
         return false;
 
-    b = *m_it++;
+    b = m_pb[m_pos++];
     return true;
 }
 
 std::vector<uint8_t> MemFile::read(int len)
 {
     auto avail_bytes = std::min(len, remaining());
-    std::vector<uint8_t> data(m_it, m_it + avail_bytes);
-    m_it += avail_bytes;
+    std::vector<uint8_t> data(m_pb + m_pos, m_pb + m_pos + avail_bytes);
+    m_pos += avail_bytes;
     return data;
 }
 
@@ -362,8 +557,8 @@ bool MemFile::read(void* buf, int len)
 
     if (avail)
     {
-        memcpy(buf, &(*m_it), avail);   // make this safer when callers can cope
-        m_it += avail;
+        memcpy(buf, m_pb + m_pos, avail);   // make this safer when callers can cope
+        m_pos += avail;
     }
     return true;
 }
@@ -384,16 +579,16 @@ bool MemFile::rewind()
 
 bool MemFile::seek(int offset)
 {
-    m_it = m_data.begin() + std::min(offset, static_cast<int>(m_data.size()));
+    m_pos = std::min(offset, m_size);
     return tell() == offset;
 }
 
 int MemFile::tell() const
 {
-    return static_cast<int>(m_it - m_data.begin());
+    return m_pos;
 }
 
 bool MemFile::eof() const
 {
-    return m_it == m_data.end();
+    return m_pos == m_size;
 }
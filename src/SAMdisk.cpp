@@ -6,10 +6,10 @@
 #include "BlockDevice.h"
 #include "FluxDecoder.h"
 
-enum { cmdCopy, cmdScan, cmdFormat, cmdList, cmdView, cmdInfo, cmdDir, cmdRpm, cmdVerify, cmdUnformat, cmdVersion, cmdCreate, cmdEnd };
+enum { cmdCopy, cmdScan, cmdFormat, cmdList, cmdView, cmdInfo, cmdDir, cmdRpm, cmdVerify, cmdUnformat, cmdVersion, cmdCreate, cmdBatch, cmdEnd };
 
 static const char* aszCommands[] =
-{ "copy",  "scan",  "format",  "list",  "view",  "info",  "dir",  "rpm",  "verify",  "unformat",  "version",  "create",  nullptr };
+{ "copy",  "scan",  "format",  "list",  "view",  "info",  "dir",  "rpm",  "verify",  "unformat",  "version",  "create",  "batch",  nullptr };
 
 
 OPTIONS opt;
@@ -26,13 +26,13 @@ int Usage()
     Format fmtMGT = RegularFormat::MGT;
 
     util::cout << "\n"
-        << " SAMDISK [copy|scan|format|list|view|info|dir|rpm] <args>\n"
+        << " SAMDISK [copy|scan|format|list|view|info|dir|rpm|batch] <args>\n"
         << "\n"
         << "  -c, --cyls=N        cylinder count (N) or range (A-B)\n"
         << "  -h, --head=N        single head select (0 or 1)\n"
         << "  -s, --sector[s]     sector count for format, or single sector select\n"
         << "  -r, --retries=N     retry count for bad sectors (default=" << opt.retries << ")\n"
-        << "  -R, --rescans=N     rescan count for full track reads (default=" << opt.rescans << ")\n"
+        << "  -R, --rescans=N     max full track rescans, ending early once error-free and unchanged (default=" << opt.rescans << ")\n"
         << "  -d, --double-step   step floppy head twice between tracks\n"
         << "  -f, --force         suppress confirmation prompts (careful!)\n"
         << "\n"
@@ -138,7 +138,8 @@ extern "C" {
 enum {
     OPT_RPM = 256, OPT_LOG, OPT_VERSION, OPT_HEAD0, OPT_HEAD1, OPT_GAPMASK, OPT_MAXCOPIES,
     OPT_MAXSPLICE, OPT_CHECK8K, OPT_BYTES, OPT_HDF, OPT_ORDER, OPT_SCALE, OPT_PLLADJUST,
-    OPT_PLLPHASE, OPT_ACE, OPT_MX, OPT_AGAT, OPT_NOFM, OPT_STEPRATE, OPT_PREFER, OPT_DEBUG
+    OPT_PLLPHASE, OPT_ACE, OPT_MX, OPT_AGAT, OPT_NOFM, OPT_STEPRATE, OPT_PREFER, OPT_DEBUG,
+    OPT_COMPLEVEL, OPT_BLOCKSIZE, OPT_PRECOMP
 };
 
 struct option long_options[] =
@@ -226,6 +227,7 @@ struct option long_options[] =
     { "legacy",           no_argument, &opt.legacy, 1 },
     { "time",             no_argument, &opt.time, 1 },          // undocumented
     { "tty",              no_argument, &opt.tty, 1 },
+    { "direct",           no_argument, &opt.direct, 1 },
     { "help",             no_argument, nullptr, 0 },
 
     { "log",        optional_argument, nullptr, OPT_LOG },
@@ -243,6 +245,9 @@ struct option long_options[] =
     { "scale",      required_argument, nullptr, OPT_SCALE },
     { "pll-adjust", required_argument, nullptr, OPT_PLLADJUST },
     { "pll-phase",  required_argument, nullptr, OPT_PLLPHASE },
+    { "compress-level",required_argument,nullptr, OPT_COMPLEVEL },
+    { "block-size", required_argument, nullptr, OPT_BLOCKSIZE },
+    { "precomp",    required_argument, nullptr, OPT_PRECOMP },
 
     { 0, 0, 0, 0 }
 };
@@ -427,6 +432,22 @@ bool ParseCommandLine(int argc_, char* argv_[])
                 throw util::exception("invalid step rate '", optarg, "', expected 0-15");
             break;
 
+        case OPT_COMPLEVEL:
+            opt.complevel = util::str_value<int>(optarg);
+            if (opt.complevel < 0 || opt.complevel > 9)
+                throw util::exception("invalid compression level '", optarg, "', expected 0-9");
+            break;
+
+        case OPT_BLOCKSIZE:
+            opt.blocksize = util::str_value<int>(optarg);
+            if (opt.blocksize <= 0 || opt.blocksize > MAX_BLOCK_SIZE_KB)
+                throw util::exception("invalid block size '", optarg, "', expected 1-", MAX_BLOCK_SIZE_KB, " (KB)");
+            break;
+
+        case OPT_PRECOMP:
+            opt.precomp = precomp_from_string(optarg);
+            break;
+
         case OPT_BYTES:
             util::str_range(optarg, opt.bytes_begin, opt.bytes_end);
             break;
@@ -742,6 +763,15 @@ int main(int argc_, char* argv_[])
             break;
         }
 
+        case cmdBatch:
+        {
+            if (nSource == argNone || nTarget == argNone)
+                Usage();
+
+            f = BatchConvert(opt.szSource, opt.szTarget);
+            break;
+        }
+
         case cmdVersion:
         {
             if (nSource != argNone || nTarget != argNone)
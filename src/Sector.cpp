@@ -13,7 +13,7 @@ bool Sector::operator== (const Sector& sector) const
         return false;
 
     // If neither has data it's a match
-    if (sector.m_data.size() == 0 && m_data.size() == 0)
+    if (sector.copies() == 0 && copies() == 0)
         return true;
 
     // Both sectors must have some data
@@ -24,7 +24,10 @@ bool Sector::operator== (const Sector& sector) const
     if (sector.data_size() < sector.size() || data_size() < size())
         return false;
 
-    // The natural data contents must match
+    // The natural data contents must match, as they do if shared
+    if (sector.m_data == m_data)
+        return true;
+
     return std::equal(data_copy().begin(), data_copy().begin() + size(), sector.data_copy().begin());
 }
 
@@ -35,35 +38,51 @@ int Sector::size() const
 
 int Sector::data_size() const
 {
-    return copies() ? static_cast<int>(m_data[0].size()) : 0;
+    return copies() ? static_cast<int>(datas()[0].size()) : 0;
 }
 
 const DataList& Sector::datas() const
 {
-    return m_data;
+    static const DataList no_data;
+    return m_data ? *m_data : no_data;
 }
 
 DataList& Sector::datas()
 {
-    return m_data;
+    return unshared_datas();
 }
 
 const Data& Sector::data_copy(int copy/*=0*/) const
 {
-    copy = std::max(std::min(copy, static_cast<int>(m_data.size()) - 1), 0);
-    return m_data[copy];
+    auto& data = datas();
+    copy = std::max(std::min(copy, static_cast<int>(data.size()) - 1), 0);
+    return data[copy];
 }
 
 Data& Sector::data_copy(int copy/*=0*/)
 {
-    assert(m_data.size() != 0);
-    copy = std::max(std::min(copy, static_cast<int>(m_data.size()) - 1), 0);
-    return m_data[copy];
+    auto& data = unshared_datas();
+    assert(data.size() != 0);
+    copy = std::max(std::min(copy, static_cast<int>(data.size()) - 1), 0);
+    return data[copy];
 }
 
 int Sector::copies() const
 {
-    return static_cast<int>(m_data.size());
+    return m_data ? static_cast<int>(m_data->size()) : 0;
+}
+
+// Data copies are shared by copies of a sector until one of them changes
+// them, so copying tracks between representations doesn't copy the data.
+// Mutable access gives this sector its own copy of the list, if shared.
+DataList& Sector::unshared_datas()
+{
+    if (!m_data)
+        m_data = std::make_shared<DataList>();
+    else if (m_data.use_count() > 1)
+        m_data = std::make_shared<DataList>(*m_data);
+
+    return *m_data;
 }
 
 Sector::Merge Sector::add(Data&& new_data, bool bad_crc, uint8_t new_dam)
@@ -112,7 +131,8 @@ Sector::Merge Sector::add(Data&& new_data, bool bad_crc, uint8_t new_dam)
         else if (copies() == 1)
         {
             // Can we identify the method used by the existing copy?
-            if (!ChecksumMethods(m_data[0].data(), m_data[0].size()).empty())
+            auto& data0 = (*m_data)[0];
+            if (!ChecksumMethods(data0.data(), data0.size()).empty())
             {
                 // Keep the existing, ignoring the new data
                 return Merge::Unchanged;
@@ -124,9 +144,10 @@ Sector::Merge Sector::add(Data&& new_data, bool bad_crc, uint8_t new_dam)
     auto complete_size = is_8k_sector() ? 0x1800 : new_data.size();
 
     // Compare existing data with the new data, to avoid storing redundant copies.
-    for (auto it = m_data.begin(); it != m_data.end(); )
+    // Copies are only unshared if one of them is to be replaced.
+    for (auto i = 0; i < copies(); )
     {
-        auto& data = *it;
+        auto& data = (*m_data)[i];
 
         if (data.size() >= complete_size && new_data.size() >= complete_size)
         {
@@ -146,7 +167,8 @@ Sector::Merge Sector::add(Data&& new_data, bool bad_crc, uint8_t new_dam)
                     return Merge::Unchanged;
 
                 // The new shorter copy replaces the existing data.
-                it = m_data.erase(it);
+                auto& copies_list = unshared_datas();
+                copies_list.erase(copies_list.begin() + i);
                 ret = Merge::Improved;
                 continue;
             }
@@ -161,13 +183,14 @@ Sector::Merge Sector::add(Data&& new_data, bool bad_crc, uint8_t new_dam)
                     return Merge::Unchanged;
 
                 // The new longer copy replaces the existing data.
-                it = m_data.erase(it);
+                auto& copies_list = unshared_datas();
+                copies_list.erase(copies_list.begin() + i);
                 ret = Merge::Improved;
                 continue;
             }
         }
 
-        ++it;
+        ++i;
     }
 
     // Will we now have multiple copies?
@@ -186,17 +209,23 @@ Sector::Merge Sector::add(Data&& new_data, bool bad_crc, uint8_t new_dam)
         if (!has_baddatacrc())
             return Merge::Unchanged;
 
+        // If we're already at the copy limit, the new copy is trimmed again
+        // below. Only report a change if it shortens the existing copies.
+        if (copies() >= opt.maxcopies && dam == new_dam &&
+            static_cast<int>(new_data.size()) >= data_size())
+            return Merge::Unchanged;
+
         // Keep multiple copies the same size, whichever is shortest
-        auto new_size = std::min(new_data.size(), m_data[0].size());
+        auto new_size = std::min(new_data.size(), (*m_data)[0].size());
         new_data.resize(new_size);
 
         // Resize any existing copies to match
-        for (auto& d : m_data)
+        for (auto& d : unshared_datas())
             d.resize(new_size);
     }
 
     // Insert the new data copy.
-    m_data.emplace_back(std::move(new_data));
+    unshared_datas().emplace_back(std::move(new_data));
     limit_copies(opt.maxcopies);
 
     // Update the data CRC state and DAM
@@ -231,15 +260,15 @@ Sector::Merge Sector::merge(Sector&& sector)
     if (!has_baddatacrc() && sector.has_baddatacrc())
         return ret;
 
-    // Add the new data snapshots
-    for (Data& data : sector.m_data)
+    // Add the new data snapshots, which may be shared with other sectors
+    for (auto& data : sector.datas())
     {
         // Move the data into place, passing on the existing data CRC status and DAM
         auto add_ret = add(std::move(data), sector.has_baddatacrc(), sector.dam);
         if (add_ret == Merge::Improved || (ret == Merge::Unchanged))
             ret = add_ret;
     }
-    sector.m_data.clear();
+    sector.m_data.reset();
 
     return ret;
 }
@@ -314,15 +343,16 @@ void Sector::set_baddatacrc(bool bad)
         auto fill_byte = static_cast<uint8_t>((opt.fill >= 0) ? opt.fill : 0);
 
         if (!has_data())
-            m_data.push_back(Data(size(), fill_byte));
+            unshared_datas().push_back(Data(size(), fill_byte));
         else if (copies() > 1)
         {
-            m_data.resize(1);
+            auto& data = unshared_datas();
+            data.resize(1);
 
             if (data_size() < size())
             {
                 auto pad{ Data(size() - data_size(), fill_byte) };
-                m_data[0].insert(m_data[0].begin(), pad.begin(), pad.end());
+                data[0].insert(data[0].begin(), pad.begin(), pad.end());
             }
         }
     }
@@ -330,7 +360,7 @@ void Sector::set_baddatacrc(bool bad)
 
 void Sector::remove_data()
 {
-    m_data.clear();
+    m_data.reset();
     m_bad_data_crc = false;
     dam = 0xfb;
 }
@@ -338,7 +368,7 @@ void Sector::remove_data()
 void Sector::limit_copies(int max_copies)
 {
     if (copies() > max_copies)
-        m_data.resize(max_copies);
+        unshared_datas().resize(max_copies);
 }
 
 void Sector::remove_gapdata(bool keep_crc/*=false*/)
@@ -346,7 +376,7 @@ void Sector::remove_gapdata(bool keep_crc/*=false*/)
     if (!has_gapdata())
         return;
 
-    for (auto& data : m_data)
+    for (auto& data : unshared_datas())
     {
         // If requested, attempt to preserve CRC bytes on bad sectors.
         if (keep_crc && has_baddatacrc() && data.size() >= (size() + 2))
@@ -0,0 +1,225 @@
+// Bitstream sync pattern search, using SSE2/AVX2 where available
+
+#include "SAMdisk.h"
+#include "SyncFinder.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_SSE2_SEARCH
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+
+// A pair of byte-aligned pattern bytes, used as a quick filter before the
+// full pattern is checked at each of the bit alignments sharing the pair.
+struct Probe
+{
+    uint8_t value1 = 0, mask1 = 0, value2 = 0, mask2 = 0;
+    std::vector<std::pair<int, int>> checks{};  // pattern index, bit alignment
+};
+
+// Patterns are held reversed, to match the lsb first bit order in memory.
+struct Search
+{
+    const uint8_t* data = nullptr;
+    int bytes = 0;
+    int bitsize = 0;
+    std::vector<uint32_t> values{}, masks{};
+    std::vector<Probe> probes{};
+    std::vector<int> offsets{};
+};
+
+uint32_t reverse32(uint32_t x)
+{
+    uint32_t r = 0;
+    for (auto i = 0; i < 32; ++i, x >>= 1)
+        r = (r << 1) | (x & 1);
+    return r;
+}
+
+int lowest_bit(uint32_t x)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(x);
+#endif
+}
+
+// Check each pattern sharing the probe, at the given start byte.
+void check_probe(Search& search, const Probe& probe, int start_byte)
+{
+    uint64_t bits = 0;
+    for (auto i = 4; i >= 0; --i)
+    {
+        auto offset = start_byte + i;
+        bits = (bits << 8) | ((offset < search.bytes) ? search.data[offset] : 0);
+    }
+
+    for (auto& check : probe.checks)
+    {
+        auto start = start_byte * 8 + check.second;
+        auto dword = static_cast<uint32_t>(bits >> check.second);
+
+        if ((dword & search.masks[check.first]) == search.values[check.first] &&
+            start + 32 <= search.bitsize)
+        {
+            search.offsets.push_back(start + 32);
+        }
+    }
+}
+
+void search_scalar(Search& search, int start_byte, int end_byte)
+{
+    for (auto i = start_byte; i < end_byte; ++i)
+    {
+        for (auto& probe : search.probes)
+        {
+            if ((search.data[i + 1] & probe.mask1) == probe.value1 &&
+                (search.data[i + 2] & probe.mask2) == probe.value2)
+            {
+                check_probe(search, probe, i);
+            }
+        }
+    }
+}
+
+#ifdef HAVE_SSE2_SEARCH
+int search_sse2(Search& search, int end_byte)
+{
+    auto i = 0;
+    for (; i + 16 <= end_byte && i + 18 <= search.bytes; i += 16)
+    {
+        auto v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(search.data + i + 1));
+        auto v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(search.data + i + 2));
+
+        for (auto& probe : search.probes)
+        {
+            auto eq1 = _mm_cmpeq_epi8(_mm_and_si128(v1, _mm_set1_epi8(static_cast<char>(probe.mask1))),
+                _mm_set1_epi8(static_cast<char>(probe.value1)));
+            auto eq2 = _mm_cmpeq_epi8(_mm_and_si128(v2, _mm_set1_epi8(static_cast<char>(probe.mask2))),
+                _mm_set1_epi8(static_cast<char>(probe.value2)));
+
+            auto hits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(eq1, eq2)));
+            for (; hits; hits &= hits - 1)
+                check_probe(search, probe, i + lowest_bit(hits));
+        }
+    }
+
+    return i;
+}
+
+TARGET_AVX2 int search_avx2(Search& search, int end_byte)
+{
+    auto i = 0;
+    for (; i + 32 <= end_byte && i + 34 <= search.bytes; i += 32)
+    {
+        auto v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(search.data + i + 1));
+        auto v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(search.data + i + 2));
+
+        for (auto& probe : search.probes)
+        {
+            auto eq1 = _mm256_cmpeq_epi8(_mm256_and_si256(v1, _mm256_set1_epi8(static_cast<char>(probe.mask1))),
+                _mm256_set1_epi8(static_cast<char>(probe.value1)));
+            auto eq2 = _mm256_cmpeq_epi8(_mm256_and_si256(v2, _mm256_set1_epi8(static_cast<char>(probe.mask2))),
+                _mm256_set1_epi8(static_cast<char>(probe.value2)));
+
+            auto hits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(eq1, eq2)));
+            for (; hits; hits &= hits - 1)
+                check_probe(search, probe, i + lowest_bit(hits));
+        }
+    }
+
+    return i;
+}
+
+bool cpu_has_avx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6)  // OSXSAVE, and XMM+YMM state
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif // HAVE_SSE2_SEARCH
+
+} // namespace
+
+
+std::vector<int> find_sync(const uint8_t* data, int bitsize, const std::vector<SyncPattern>& patterns)
+{
+    Search search;
+    search.data = data;
+    search.bitsize = bitsize;
+    search.bytes = (bitsize + 7) / 8;
+
+    if (bitsize < 32 || patterns.empty())
+        return {};
+
+    for (auto& pattern : patterns)
+    {
+        search.values.push_back(reverse32(pattern.value & pattern.mask));
+        search.masks.push_back(reverse32(pattern.mask));
+    }
+
+    // Every 32-bit pattern alignment fully covers the 2nd and 3rd bytes, so
+    // use them as the probe, sharing probes between identical byte pairs.
+    for (auto i = 0; i < static_cast<int>(patterns.size()); ++i)
+    {
+        for (auto shift = 0; shift < 8; ++shift)
+        {
+            auto value = static_cast<uint64_t>(search.values[i]) << shift;
+            auto mask = static_cast<uint64_t>(search.masks[i]) << shift;
+
+            Probe probe;
+            probe.value1 = static_cast<uint8_t>(value >> 8);
+            probe.mask1 = static_cast<uint8_t>(mask >> 8);
+            probe.value2 = static_cast<uint8_t>(value >> 16);
+            probe.mask2 = static_cast<uint8_t>(mask >> 16);
+
+            auto it = std::find_if(search.probes.begin(), search.probes.end(), [&](const Probe& p) {
+                return p.value1 == probe.value1 && p.mask1 == probe.mask1 &&
+                    p.value2 == probe.value2 && p.mask2 == probe.mask2;
+                });
+
+            if (it == search.probes.end())
+                it = search.probes.insert(search.probes.end(), std::move(probe));
+
+            it->checks.emplace_back(i, shift);
+        }
+    }
+
+    // Start bytes for which a pattern could end within the bitstream.
+    auto end_byte = (bitsize - 32) / 8 + 1;
+    auto done = 0;
+
+#ifdef HAVE_SSE2_SEARCH
+    static const bool use_avx2 = cpu_has_avx2();
+    done = use_avx2 ? search_avx2(search, end_byte) : search_sse2(search, end_byte);
+#endif
+
+    search_scalar(search, done, end_byte);
+
+    std::sort(search.offsets.begin(), search.offsets.end());
+    search.offsets.erase(std::unique(search.offsets.begin(), search.offsets.end()), search.offsets.end());
+    return search.offsets;
+}
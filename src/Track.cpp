@@ -44,6 +44,7 @@ const std::vector<Sector>& Track::sectors() const
 
 std::vector<Sector>& Track::sectors()
 {
+    m_order = Order::Unknown;
     return m_sectors;
 }
 
@@ -56,15 +57,13 @@ const Sector& Track::operator [] (int index) const
 Sector& Track::operator [] (int index)
 {
     assert(index < static_cast<int>(m_sectors.size()));
+    m_order = Order::Unknown;
     return m_sectors[index];
 }
 
 int Track::index_of(const Sector& sector) const
 {
-    auto it = std::find_if(begin(), end(), [&](const Sector& s) {
-        return &s == &sector;
-        });
-
+    auto it = find(sector);
     return (it == end()) ? -1 : static_cast<int>(std::distance(begin(), it));
 }
 
@@ -200,31 +199,32 @@ Track::AddResult Track::add(Sector&& sector)
     // If there's no positional information, simply append
     if (sector.offset == 0)
     {
+        if (!m_sectors.empty() && m_sectors.back().offset > 0)
+            m_order = Order::Unordered;
         m_sectors.emplace_back(std::move(sector));
         return AddResult::Append;
     }
     else
     {
         // Find a sector close enough to the new offset to be the same one
-        auto it = std::find_if(begin(), end(), [&](const Sector& s) {
-            auto offset_min = std::min(sector.offset, s.offset);
-            auto offset_max = std::max(sector.offset, s.offset);
-            auto distance = std::min(offset_max - offset_min, tracklen + offset_min - offset_max);
-
-            // Sector must be close enough and have the same header
-            if (distance <= COMPARE_TOLERANCE_BITS && sector.header == s.header)
-                return true;
-
-            return false;
-            });
+        auto it = find_nearby(sector);
 
         // If that failed, we have a new sector with an offset
-        if (it == end())
+        if (it == m_sectors.end())
         {
             // Find the insertion point to keep the sectors in order
-            it = std::find_if(begin(), end(), [&](const Sector& s) {
-                return sector.offset < s.offset;
-                });
+            if (is_ordered())
+            {
+                it = std::upper_bound(m_sectors.begin(), m_sectors.end(), sector.offset,
+                    [](int offset, const Sector& s) { return offset < s.offset; });
+            }
+            else
+            {
+                it = std::find_if(m_sectors.begin(), m_sectors.end(), [&](const Sector& s) {
+                    return sector.offset < s.offset;
+                    });
+            }
+
             m_sectors.emplace(it, std::move(sector));
             return AddResult::Insert;
         }
@@ -244,6 +244,69 @@ Track::AddResult Track::add(Sector&& sector)
     }
 }
 
+// Check whether the sectors are in offset order, as they are when only added
+// by add(), so they can be binary searched. Mutable access to the sectors
+// makes the order unknown, so it's checked again here on next use.
+bool Track::is_ordered()
+{
+    if (m_order == Order::Unknown)
+    {
+        auto ordered = std::is_sorted(m_sectors.begin(), m_sectors.end(), [](const Sector& a, const Sector& b) {
+            return a.offset < b.offset;
+            });
+        m_order = ordered ? Order::Ordered : Order::Unordered;
+    }
+
+    return m_order == Order::Ordered;
+}
+
+// Find the first sector with the same header as the supplied sector, and an
+// offset close enough to be the same one. Distances wrap at the track length.
+std::vector<Sector>::iterator Track::find_nearby(const Sector& sector)
+{
+    auto is_match = [&](const Sector& s) {
+        auto offset_min = std::min(sector.offset, s.offset);
+        auto offset_max = std::max(sector.offset, s.offset);
+        auto distance = std::min(offset_max - offset_min, tracklen + offset_min - offset_max);
+
+        // Sector must be close enough and have the same header
+        return distance <= COMPARE_TOLERANCE_BITS && sector.header == s.header;
+    };
+
+    if (!is_ordered())
+        return std::find_if(m_sectors.begin(), m_sectors.end(), is_match);
+
+    // Index of the first sector at or after the given offset.
+    auto index_at = [&](int offset) {
+        return static_cast<int>(std::distance(m_sectors.begin(),
+            std::lower_bound(m_sectors.begin(), m_sectors.end(), offset,
+                [](const Sector& s, int value) { return s.offset < value; })));
+    };
+
+    // Sectors are close within the tolerance either side, or within it across
+    // the wrap, which is a difference of at least tracklen less the tolerance.
+    auto wrap_distance = tracklen - COMPARE_TOLERANCE_BITS;
+    std::array<std::pair<int, int>, 3> ranges{ {
+        { 0, index_at(sector.offset - wrap_distance + 1) },
+        { index_at(sector.offset - COMPARE_TOLERANCE_BITS), index_at(sector.offset + COMPARE_TOLERANCE_BITS + 1) },
+        { index_at(sector.offset + wrap_distance), size() } } };
+
+    // Check the (possibly overlapping) ranges in order, to find the first match.
+    auto checked = 0;
+    for (auto& range : ranges)
+    {
+        for (auto i = std::max(range.first, checked); i < range.second; ++i)
+        {
+            if (is_match(m_sectors[i]))
+                return m_sectors.begin() + i;
+        }
+
+        checked = std::max(checked, range.second);
+    }
+
+    return m_sectors.end();
+}
+
 Track& Track::format(const CylHead& cylhead, const Format& fmt)
 {
     assert(fmt.sectors != 0);
@@ -287,6 +350,7 @@ Data::const_iterator Track::populate(Data::const_iterator it, Data::const_iterat
 void Track::insert(int index, Sector&& sector)
 {
     assert(index <= static_cast<int>(m_sectors.size()));
+    m_order = Order::Unknown;
 
     if (!m_sectors.empty() && m_sectors[0].datarate != sector.datarate)
         throw util::exception("can't mix datarates on a track");
@@ -307,9 +371,8 @@ Sector Track::remove(int index)
 
 std::vector<Sector>::iterator Track::find(const Sector& sector)
 {
-    return std::find_if(begin(), end(), [&](const Sector& s) {
-        return &s == &sector;
-        });
+    auto index = index_of(sector);
+    return (index < 0) ? end() : begin() + index;
 }
 
 std::vector<Sector>::iterator Track::find(const Header& header)
@@ -328,9 +391,13 @@ std::vector<Sector>::iterator Track::find(const Header& header, const DataRate d
 
 std::vector<Sector>::const_iterator Track::find(const Sector& sector) const
 {
-    return std::find_if(begin(), end(), [&](const Sector& s) {
-        return &s == &sector;
-        });
+    // Sectors are stored contiguously, so the address gives the position.
+    std::less<const Sector*> less;
+    auto p = &sector;
+    if (less(p, m_sectors.data()) || !less(p, m_sectors.data() + m_sectors.size()))
+        return end();
+
+    return begin() + (p - m_sectors.data());
 }
 
 std::vector<Sector>::const_iterator Track::find(const Header& header) const
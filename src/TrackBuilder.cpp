@@ -4,6 +4,49 @@
 #include "TrackBuilder.h"
 #include "IBMPC.h"
 
+namespace
+{
+
+// Encoded bits for each data byte, most significant first. MFM depends on
+// the previous data bit, and FM bits are doubled as for addBit().
+struct EncodingTables
+{
+    EncodingTables()
+    {
+        for (auto byte = 0; byte < 256; ++byte)
+        {
+            for (auto lastbit = 0; lastbit < 2; ++lastbit)
+            {
+                auto prev = lastbit != 0;
+                uint16_t bits = 0;
+                for (auto i = 7; i >= 0; --i)
+                {
+                    auto bit = ((byte >> i) & 1) != 0;
+                    bits = static_cast<uint16_t>((bits << 2) | ((!prev && !bit) << 1) | bit);
+                    prev = bit;
+                }
+                mfm[lastbit][byte] = bits;
+            }
+
+            uint32_t bits = 0;
+            for (auto i = 7; i >= 0; --i)
+                bits = (bits << 4) | 0x8 | (((byte >> i) & 1) << 1);
+            fm[byte] = bits;
+        }
+    }
+
+    std::array<std::array<uint16_t, 256>, 2> mfm{};
+    std::array<uint32_t, 256> fm{};
+};
+
+const EncodingTables& encoding_tables()
+{
+    static const EncodingTables tables;
+    return tables;
+}
+
+} // namespace
+
 TrackBuilder::TrackBuilder(DataRate datarate, Encoding encoding)
     : m_datarate(datarate)
 {
@@ -25,6 +68,14 @@ void TrackBuilder::setEncoding(Encoding encoding)
     }
 }
 
+// Add raw bits, most significant first. Builders override this to store
+// them faster than a bit at a time.
+void TrackBuilder::addRawBits(uint32_t bits, int num_bits)
+{
+    while (num_bits-- > 0)
+        addRawBit(((bits >> num_bits) & 1) != 0);
+}
+
 void TrackBuilder::addBit(bool bit)
 {
     addRawBit(bit);
@@ -53,11 +104,16 @@ void TrackBuilder::addDataBit(bool bit)
 
 void TrackBuilder::addByte(int byte)
 {
-    for (auto i = 0; i < 8; ++i)
-    {
-        addDataBit((byte & 0x80) != 0);
-        byte <<= 1;
-    }
+    // Equivalent to addDataBit() for each bit, using the encoding tables.
+    auto& tables = encoding_tables();
+    byte &= 0xff;
+
+    if (m_encoding == Encoding::FM)
+        addRawBits(tables.fm[byte], 32);
+    else
+        addRawBits(tables.mfm[m_lastbit][byte], 16);
+
+    m_lastbit = (byte & 1) != 0;
 }
 
 void TrackBuilder::addByteUpdateCrc(int byte)
@@ -99,11 +155,8 @@ void TrackBuilder::addBlockUpdateCrc(int byte, int count)
 
 void TrackBuilder::addBlockUpdateCrc(const Data& data)
 {
-    for (auto& byte : data)
-    {
-        addByte(byte);
-        m_crc.add(byte);
-    }
+    addBlock(data);
+    m_crc.add(data.data(), data.size());
 }
 
 void TrackBuilder::addGap(int count, int fill)
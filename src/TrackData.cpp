@@ -27,6 +27,12 @@ TrackData::TrackData(const CylHead& cylhead_, FluxData&& flux, bool normalised)
     add(std::move(flux), normalised);
 }
 
+TrackData::TrackData(const CylHead& cylhead_, CompactFlux&& flux, bool normalised)
+    : cylhead(cylhead_), m_type(TrackDataType::Flux)
+{
+    add(std::move(flux), normalised);
+}
+
 
 bool TrackData::has_track() const
 {
@@ -86,7 +92,7 @@ const Track& TrackData::track()
     return m_bitstream;
 }
 
-const FluxData& TrackData::flux()
+const CompactFlux& TrackData::flux()
 {
     if (!has_flux())
     {
@@ -105,41 +111,51 @@ const FluxData& TrackData::flux()
 
 TrackData TrackData::preferred()
 {
+    TrackData trackdata;
+
     switch (opt.prefer)
     {
     case PreferredData::Track:
-        return { cylhead, Track(track()) };
+        trackdata = { cylhead, Track(track()) };
+        break;
     case PreferredData::Bitstream:
-        return { cylhead, BitBuffer(bitstream()) };
+        trackdata = { cylhead, BitBuffer(bitstream()) };
+        break;
     case PreferredData::Flux:
-        return { cylhead, FluxData(flux()) };
+        trackdata = { cylhead, CompactFlux(flux()) };
+        break;
     case PreferredData::Unknown:
+        trackdata = *this;
+        if (trackdata.has_flux() && !trackdata.has_normalised_flux())
+        {
+            // Ensure there are track and bitstream representations, then clear
+            // the unnormalised flux, as its use must be explicitly requested.
+            trackdata.track();
+            trackdata.m_flux.clear();
+            trackdata.m_flags &= ~TD_FLUX;
+        }
         break;
     }
 
-    auto trackdata = *this;
-    if (trackdata.has_flux() && !trackdata.has_normalised_flux())
-    {
-        // Ensure there are track and bitstream representations, then clear
-        // the unnormalised flux, as its use must be explicitly requested.
-        trackdata.track();
-        trackdata.m_flux.clear();
-        trackdata.m_flags &= ~TD_FLUX;
-    }
+    trackdata.hint = hint;
     return trackdata;
 }
 
 
 void TrackData::add(TrackData&& trackdata)
 {
+    if (!hint)
+        hint = trackdata.hint;
+
+    // Take over the representations rather than copying them.
     if (trackdata.has_flux())
-        add(FluxData(trackdata.flux()), trackdata.has_normalised_flux());
+        add(std::move(trackdata.m_flux), trackdata.has_normalised_flux());
 
     if (trackdata.has_bitstream())
-        add(BitBuffer(trackdata.bitstream()));
+        add(std::move(trackdata.m_bitstream));
 
     if (trackdata.has_track())
-        add(Track(trackdata.track()));
+        add(std::move(trackdata.m_track));
 }
 
 void TrackData::add(Track&& track)
@@ -163,6 +179,11 @@ void TrackData::add(BitBuffer&& bitstream)
 }
 
 void TrackData::add(FluxData&& flux, bool normalised)
+{
+    add(CompactFlux(flux), normalised);
+}
+
+void TrackData::add(CompactFlux&& flux, bool normalised)
 {
     m_normalised_flux = normalised;
     m_flux = std::move(flux);
@@ -2,10 +2,23 @@
 
 #include "SAMdisk.h"
 
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
 std::set<std::string> seen_messages;
+std::mutex message_mutex;
+MessageCounts* message_counts;
+thread_local DeferredMessages* deferred_messages;
 
 static uint32_t adwUsed[2][3];
 
+void ShowDeferredMessages(const DeferredMessages& messages)
+{
+    for (auto& message : messages)
+        Message(message.first, "%s", message.second.c_str());
+}
+
 const char* ValStr(int val, const char* pcszDec_, const char* pcszHex_, bool fForceDecimal_)
 {
     static char strs[8][32];
@@ -202,6 +215,36 @@ bool IsDir(const std::string& path)
 #endif
 }
 
+// Names of the entries in a directory, or none if it can't be read.
+std::vector<std::string> ListDir(const std::string& path)
+{
+    std::vector<std::string> names;
+
+#ifdef _WIN32
+    WIN32_FIND_DATA wfd;
+    auto hfind = FindFirstFile((path + PATH_SEPARATOR_CHR + "*").c_str(), &wfd);
+    if (hfind != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            names.push_back(wfd.cFileName);
+        } while (FindNextFile(hfind, &wfd));
+
+        FindClose(hfind);
+    }
+#else
+    if (auto dir = opendir(path.c_str()))
+    {
+        while (auto entry = readdir(dir))
+            names.push_back(entry->d_name);
+
+        closedir(dir);
+    }
+#endif
+
+    return names;
+}
+
 bool IsFloppy(const std::string& path)
 {
     // Accept anything in the format X: as we'll check it more thoroughly later.
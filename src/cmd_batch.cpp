@@ -0,0 +1,334 @@
+// Batch command: convert many images in one run
+
+#include "SAMdisk.h"
+#include "ThreadPool.h"
+
+#if defined(HAVE_FORK) && defined(HAVE_SYS_WAIT_H)
+#define HAVE_BATCH_WORKERS
+#include <sys/wait.h>
+#endif
+
+namespace
+{
+
+// Limit on the estimated memory use of images being converted at once.
+constexpr int64_t BATCH_MEMORY_BUDGET = 1024 * 1024 * 1024;
+
+// Estimated peak memory for a conversion, as a multiple of the source size.
+// Flux sources hold their samples plus the decoded bitstreams and tracks.
+constexpr int IMAGE_COST_FACTOR = 4;
+constexpr int64_t MIN_IMAGE_COST = 1024 * 1024;
+
+struct BatchJob
+{
+    std::string src_path{};
+    std::string dst_path{};
+    int64_t cost = 0;
+};
+
+// Fixed layout so it can be passed back from a worker in a single pipe write.
+struct BatchResult
+{
+    bool ok = false;
+    int64_t time_ms = 0;
+    MessageCounts counts{};
+    char error[512]{};
+};
+
+bool MatchWildcard(const char* pattern, const char* name)
+{
+    for (; *pattern; ++pattern, ++name)
+    {
+        if (*pattern == '*')
+        {
+            for (; ; ++name)
+            {
+                if (MatchWildcard(pattern + 1, name))
+                    return true;
+                if (!*name)
+                    return false;
+            }
+        }
+
+        if (!*name || (*pattern != '?' &&
+            std::tolower(static_cast<uint8_t>(*pattern)) != std::tolower(static_cast<uint8_t>(*name))))
+            return false;
+    }
+
+    return !*name;
+}
+
+// Expand a directory, a wildcard file name, or a list file of source paths.
+std::vector<std::string> ExpandSources(const std::string& spec)
+{
+    std::vector<std::string> paths;
+
+    auto sep = spec.rfind(PATH_SEPARATOR_CHR);
+    auto name = (sep == spec.npos) ? spec : spec.substr(sep + 1);
+
+    if (IsDir(spec) || name.find_first_of("*?") != name.npos)
+    {
+        std::string dir = spec, pattern = "*";
+        if (!IsDir(spec))
+        {
+            dir = (sep == spec.npos) ? std::string(".") : spec.substr(0, sep ? sep : 1);
+            pattern = name;
+        }
+
+        auto prefix = (dir == ".") ? std::string() :
+            (dir.back() == PATH_SEPARATOR_CHR) ? dir : dir + PATH_SEPARATOR_CHR;
+
+        for (auto& entry : ListDir(dir))
+        {
+            if (MatchWildcard(pattern.c_str(), entry.c_str()) && IsFile(prefix + entry))
+                paths.push_back(prefix + entry);
+        }
+
+        std::sort(paths.begin(), paths.end());
+    }
+    else
+    {
+        std::ifstream list(spec);
+        if (!list)
+            throw util::exception("can't open source list ", spec);
+
+        // One path per line, ignoring blank lines and # comments.
+        std::string line;
+        while (std::getline(list, line))
+        {
+            line = util::trim(line);
+            if (!line.empty() && line[0] != '#')
+                paths.push_back(line);
+        }
+    }
+
+    return paths;
+}
+
+// Replace the * in the target pattern with the source file name, less its extension.
+std::string TargetPath(const std::string& dst_pattern, const std::string& src_path)
+{
+    auto sep = src_path.rfind(PATH_SEPARATOR_CHR);
+    auto name = (sep == src_path.npos) ? src_path : src_path.substr(sep + 1);
+
+    auto dot = name.rfind('.');
+    if (dot != name.npos && dot != 0)
+        name.erase(dot);
+
+    auto star = dst_pattern.find('*');
+    return dst_pattern.substr(0, star) + name + dst_pattern.substr(star + 1);
+}
+
+std::string CsvField(const std::string& str)
+{
+    if (str.find_first_of(",\"\r\n") == str.npos)
+        return str;
+
+    std::string quoted = "\"";
+    for (auto c : str)
+    {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+// Convert a single image, with messages tallied and other output discarded.
+BatchResult ConvertImage(const BatchJob& job)
+{
+    BatchResult result;
+    std::string error;
+
+    MessageCounts counts;
+    std::ostream null_stream(nullptr);
+    auto screen = util::cout.screen, file = util::cout.file;
+    util::cout.screen = &null_stream;
+    util::cout.file = nullptr;
+    message_counts = &counts;
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    try
+    {
+        result.ok = ImageToImage(job.src_path, job.dst_path);
+        if (!result.ok)
+            error = "conversion failed";
+    }
+    catch (std::string & e)
+    {
+        error = e;
+    }
+    catch (std::exception & e)
+    {
+        error = e.what();
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    result.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+    message_counts = nullptr;
+    util::cout.screen = screen;
+    util::cout.file = file;
+
+    result.counts = counts;
+    strncpy(result.error, error.c_str(), sizeof(result.error) - 1);
+    return result;
+}
+
+#ifdef HAVE_BATCH_WORKERS
+struct BatchWorker
+{
+    size_t index = 0;
+    int fd = -1;
+};
+
+// Each image is converted in a forked worker process. That starts it from the
+// same state as a single conversion, without the cost of a new process, and
+// isolates the batch from any image that crashes the converter.
+void RunWorkers(const std::vector<BatchJob>& jobs, std::vector<BatchResult>& results, int workers)
+{
+    std::map<pid_t, BatchWorker> running;
+    int64_t cost_running = 0;
+    size_t next = 0, done = 0;
+
+    while (done < jobs.size())
+    {
+        // Start what we can, though an image above the budget may run alone.
+        while (next < jobs.size() && static_cast<int>(running.size()) < workers &&
+            (running.empty() || cost_running + jobs[next].cost <= BATCH_MEMORY_BUDGET))
+        {
+            int fds[2];
+            if (pipe(fds) < 0)
+                throw posix_error(errno, "pipe");
+
+            // Flush first so buffered output isn't duplicated in the worker.
+            std::cout.flush();
+            util::log.flush();
+
+            auto pid = fork();
+            if (pid < 0)
+                throw posix_error(errno, "fork");
+
+            if (pid == 0)
+            {
+                close(fds[0]);
+                auto result = ConvertImage(jobs[next]);
+                auto written = write(fds[1], &result, sizeof(result));
+                _exit(written == sizeof(result) ? 0 : 1);
+            }
+
+            close(fds[1]);
+            running[pid] = { next, fds[0] };
+            cost_running += jobs[next].cost;
+            ++next;
+        }
+
+        int status = 0;
+        auto pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw posix_error(errno, "waitpid");
+        }
+
+        auto it = running.find(pid);
+        if (it == running.end())
+            continue;
+
+        auto& worker = it->second;
+        auto& result = results[worker.index];
+
+        if (read(worker.fd, &result, sizeof(result)) != sizeof(result))
+        {
+            result = BatchResult();
+            auto error = WIFSIGNALED(status) ?
+                util::fmt("worker terminated by signal %d", WTERMSIG(status)) :
+                util::fmt("worker exited with status %d", WEXITSTATUS(status));
+            strncpy(result.error, error.c_str(), sizeof(result.error) - 1);
+        }
+
+        close(worker.fd);
+        cost_running -= jobs[worker.index].cost;
+        running.erase(it);
+
+        ++done;
+        if (util::is_stdout_a_tty())
+            Message(msgStatus, "Converted %u of %u", static_cast<unsigned>(done), static_cast<unsigned>(jobs.size()));
+    }
+}
+#endif // HAVE_BATCH_WORKERS
+
+} // namespace
+
+
+bool BatchConvert(const std::string& src_spec, const std::string& dst_pattern)
+{
+    if (dst_pattern.find('*') == dst_pattern.npos)
+        throw util::exception("target pattern must contain * for the source name");
+
+    std::vector<BatchJob> jobs;
+    std::set<std::string> dst_paths;
+
+    for (auto& src_path : ExpandSources(src_spec))
+    {
+        BatchJob job;
+        job.src_path = src_path;
+        job.dst_path = TargetPath(dst_pattern, src_path);
+        job.cost = std::max(FileSize(src_path) * IMAGE_COST_FACTOR, MIN_IMAGE_COST);
+
+        if (!dst_paths.insert(util::lowercase(job.dst_path)).second)
+            throw util::exception("multiple source images would be written to ", job.dst_path);
+
+        jobs.push_back(std::move(job));
+    }
+
+    if (jobs.empty())
+        throw util::exception("no source images found for ", src_spec);
+
+    std::vector<BatchResult> results(jobs.size());
+
+    // Merge and repair targets may be shared, so those are kept in order.
+    auto workers = (opt.merge || opt.repair) ? 1 : ThreadPool::get_thread_count();
+
+#ifdef HAVE_BATCH_WORKERS
+    // Images run in parallel rather than their tracks, unless there's only one worker.
+    auto mt = opt.mt;
+    if (workers > 1)
+        opt.mt = 0;
+
+    RunWorkers(jobs, results, workers);
+    opt.mt = mt;
+#else
+    // Without worker processes, run each image from the same starting options.
+    auto batch_opt = opt;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        opt = batch_opt;
+        seen_messages.clear();
+        results[i] = ConvertImage(jobs[i]);
+        if (util::is_stdout_a_tty())
+            Message(msgStatus, "Converted %u of %u", static_cast<unsigned>(i + 1), static_cast<unsigned>(jobs.size()));
+    }
+    opt = batch_opt;
+#endif
+
+
+    // Progress is only shown on a terminal, so redirected output is just the summary.
+    auto failed = 0;
+    util::cout << "source,target,status,time_ms,info,fixes,warnings,error\n";
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        auto& result = results[i];
+        failed += !result.ok;
+
+        util::cout << CsvField(jobs[i].src_path) << ',' << CsvField(jobs[i].dst_path) << ',' <<
+            (result.ok ? "ok" : "failed") << ',' << result.time_ms << ',' <<
+            result.counts.info << ',' << result.counts.fixes << ',' << result.counts.warnings << ',' <<
+            CsvField(result.error) << '\n';
+    }
+
+    return failed == 0;
+}
@@ -3,6 +3,7 @@
 #include "SAMdisk.h"
 #include "Trinity.h"
 #include "SpectrumPlus3.h"
+#include "ThreadPool.h"
 
 bool ImageToImage(const std::string& src_path, const std::string& dst_path)
 {
@@ -36,55 +37,133 @@ bool ImageToImage(const std::string& src_path, const std::string& dst_path)
     if (opt.minimal)
         TrackUsedInit(*src_disk);
 
-    // Copy the range of tracks to the target image
+    // Tracks to copy, in the order they're written.
+    std::vector<CylHead> cylheads;
     opt.range.each([&](const CylHead& cylhead) {
         // In minimal reading mode, skip unused tracks
-        if (opt.minimal && !IsTrackUsed(cylhead.cyl, cylhead.head))
-            return;
-
-        Message(msgStatus, "Reading %s", CH(cylhead.cyl, cylhead.head));
-        auto src_data = src_disk->read(cylhead * opt.step);
-        auto src_track = src_data.track();
+        if (!opt.minimal || IsTrackUsed(cylhead.cyl, cylhead.head))
+            cylheads.push_back(cylhead);
+        }, opt.verbose != 0);
 
-        if (src_data.has_bitstream())
+    // A source track read and normalised, ready to be written in order.
+    struct SourceTrack
+    {
+        Track track{};
+        bool changed = false;
+        TrackData data{};       // source data to preserve, if the track is unchanged
+        Track dst_track{};      // normalised target track, for repair
+    };
+
+    // Read a source track, with its sectors decoded and normalised. The
+    // cached source data is only copied if it's needed for the target.
+    auto read_source = [&](const CylHead& cylhead) {
+        SourceTrack src;
+        src.track = src_disk->read_track(cylhead * opt.step);
+        const auto& src_data = src_disk->read(cylhead * opt.step);
+
+        // Bitstream normalisation only aligns sync marks, so it's only
+        // worth copying the bitstream if that's requested.
+        TrackData aligned_data;
+        if (opt.align && src_data.has_bitstream())
         {
-            auto bitstream = src_data.bitstream();
+            auto bitstream = src_disk->read_bitstream(cylhead * opt.step);
             if (NormaliseBitstream(bitstream))
             {
-                src_data = TrackData(src_data.cylhead, std::move(bitstream));
-                src_track = src_data.track();
+                aligned_data = TrackData(src_data.cylhead, std::move(bitstream));
+                aligned_data.hint = src_data.hint;
+                src.track = aligned_data.track();
             }
         }
 
-        bool changed = NormaliseTrack(cylhead, src_track);
+        src.changed = NormaliseTrack(cylhead, src.track);
+
+        if (opt.repair)
+        {
+            src.dst_track = dst_disk->read_track(cylhead);
+            NormaliseTrack(cylhead, src.dst_track);
+        }
+        else if (!src.changed)
+            src.data = aligned_data.has_bitstream() ? std::move(aligned_data) : src_data;
+
+        return src;
+    };
+
+    // Source tracks are decoded ahead on worker threads, if the source allows
+    // it, with a bounded number in flight. They are still written in order.
+    // Repairs also read the target on the workers, so it must allow that too.
+    auto threads = (opt.mt && ThreadPool::get_thread_count() > 1 && src_disk->supports_concurrent_reads() &&
+        (!opt.repair || dst_disk->supports_concurrent_reads())) ? ThreadPool::get_thread_count() : 0;
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 0)
+        pool = std::make_unique<ThreadPool>(threads);
+
+    // Worker messages are shown as each track is taken, to keep them in order.
+    auto read_deferred = [&](const CylHead& cylhead) {
+        DeferredMessages messages;
+        deferred_messages = &messages;
+        SourceTrack src;
+
+        try
+        {
+            src = read_source(cylhead);
+        }
+        catch (...)
+        {
+            deferred_messages = nullptr;
+            throw;
+        }
+
+        deferred_messages = nullptr;
+        return std::make_pair(std::move(src), std::move(messages));
+    };
+
+    std::deque<std::future<std::pair<SourceTrack, DeferredMessages>>> pending;
+    size_t next_read = 0;
+
+    // Copy the range of tracks to the target image
+    for (auto& cylhead : cylheads)
+    {
+        Message(msgStatus, "Reading %s", CH(cylhead.cyl, cylhead.head));
+
+        SourceTrack src;
+        if (pool)
+        {
+            while (next_read < cylheads.size() && pending.size() < static_cast<size_t>(threads) * 2)
+                pending.push_back(pool->enqueue(read_deferred, cylheads[next_read++]));
+
+            auto result = pending.front().get();
+            pending.pop_front();
+
+            ShowDeferredMessages(result.second);
+            src = std::move(result.first);
+        }
+        else
+            src = read_source(cylhead);
 
         if (opt.verbose)
-            ScanTrack(cylhead, src_track, context);
+            ScanTrack(cylhead, src.track, context);
 
         // Repair or copy?
         if (opt.repair)
         {
-            auto dst_track = dst_disk->read_track(cylhead);
-            NormaliseTrack(cylhead, dst_track);
-
             // Repair the target track using the source track.
-            RepairTrack(cylhead, dst_track, src_track);
+            RepairTrack(cylhead, src.dst_track, src.track);
 
-            dst_disk->write(cylhead, std::move(dst_track));
+            dst_disk->write(cylhead, std::move(src.dst_track));
         }
         else
         {
             // If the source track was modified it becomes the only track data.
-            if (changed)
-                dst_disk->write(cylhead, std::move(src_track));
+            if (src.changed)
+                dst_disk->write(cylhead, std::move(src.track));
             else
             {
                 // Preserve any source data.
-                src_data.cylhead = cylhead;
-                dst_disk->write(std::move(src_data));
+                src.data.cylhead = cylhead;
+                dst_disk->write(std::move(src.data));
             }
         }
-        }, opt.verbose != 0);
+    }
 
     // Copy any metadata not already present in the target (emplace doesn't replace)
     for (const auto& m : src_disk->metadata)
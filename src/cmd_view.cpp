@@ -96,96 +96,92 @@ void ViewTrack_MFM_FM(Encoding encoding, BitBuffer& bitbuf)
     uint8_t am = 0;
     uint16_t sync_mask = opt.a1sync ? 0xffdf : 0xffff;
 
+    auto is_am = [&](uint32_t dw) {
+        if (encoding == Encoding::MFM)
+            return (dw & sync_mask) == 0x4489;
+
+        switch (dw)
+        {
+        case 0xaa222888:    // F8/C7 DDAM
+        case 0xaa22288a:    // F9/C7 Alt-DDAM
+        case 0xaa2228a8:    // FA/C7 Alt-DAM
+        case 0xaa2228aa:    // FB/C7 DAM
+        case 0xaa2a2a88:    // FC/D7 IAM
+        case 0xaa222a8a:    // FD/C7 RX02 DAM
+        case 0xaa222aa8:    // FE/C7 IDAM
+            return encoding == Encoding::FM;
+        }
+
+        return false;
+    };
+
+    auto unit_bits = (encoding == Encoding::MFM) ? 16 : 32;
+
     bitbuf.seek(0);
     while (!bitbuf.wrapped())
     {
-        dword = (dword << 1) | bitbuf.read1();
-        ++bits;
-
+        // Advance to the next address mark or the end of the current data unit.
         bool found_am = false;
-        if (encoding == Encoding::MFM && (dword & sync_mask) == 0x4489)
+        if (!bitbuf.shift_until(dword, std::numeric_limits<int>::max(), [&](uint32_t dw) {
+            ++bits;
+            found_am = is_am(dw);
+            return found_am || bits == unit_bits;
+            }))
         {
-            found_am = true;
+            continue;
         }
-        else if (encoding == Encoding::FM)
+
+        // Decode data byte.
+        auto b = (encoding == Encoding::MFM) ?
+            BitBuffer::mfm_data_byte(dword) : BitBuffer::fm_data_byte(dword);
+        track_data.push_back(b);
+        ++am_dist;
+
+        if (encoding == Encoding::MFM && found_am)
         {
-            switch (dword)
-            {
-            case 0xaa222888:    // F8/C7 DDAM
-            case 0xaa22288a:    // F9/C7 Alt-DDAM
-            case 0xaa2228a8:    // FA/C7 Alt-DAM
-            case 0xaa2228aa:    // FB/C7 DAM
-            case 0xaa2a2a88:    // FC/D7 IAM
-            case 0xaa222a8a:    // FD/C7 RX02 DAM
-            case 0xaa222aa8:    // FE/C7 IDAM
-                found_am = true;
-                break;
-            }
+            // A1 sync byte (red if aligned to bitstream, magenta if not).
+            colours.push_back((bits == 16) ? colour::YELLOW : colour::yellow);
+            ++a1;
         }
-
-        if (found_am || (bits == (encoding == Encoding::MFM ? 16 : 32)))
+        else
         {
-            // Decode data byte.
-            uint8_t b = 0;
-            if (encoding == Encoding::MFM)
+            if (am == 0xfe && am_dist == 4)
+                data_size = Sector::SizeCodeToLength(b);
+
+            if (a1 == 3)
             {
-                for (int i = 7; i >= 0; --i)
-                    b |= static_cast<uint8_t>(((dword >> (i * 2)) & 1) << i);
+                colours.push_back(colour::RED);
+                am = b;
+                am_dist = 0;
             }
-            else
+            else if (encoding == Encoding::FM && found_am)
             {
-                for (int i = 7; i >= 0; --i)
-                    b |= static_cast<uint8_t>(((dword >> (i * 4 + 1)) & 1) << i);
+                colours.push_back((bits == 32) ? colour::RED : colour::red);
+                am = b;
+                am_dist = 0;
             }
-            track_data.push_back(b);
-            ++am_dist;
-
-            if (encoding == Encoding::MFM && found_am)
+            else if (am == 0xfe && am_dist >= 1 && am_dist <= 4)
+            {
+                colours.push_back((am_dist == 3) ? colour::GREEN : colour::green);
+            }
+            else if (am == 0xfb && am_dist >= 1 && am_dist <= data_size)
             {
-                // A1 sync byte (red if aligned to bitstream, magenta if not).
-                colours.push_back((bits == 16) ? colour::YELLOW : colour::yellow);
-                ++a1;
+                colours.push_back(colour::white);
+            }
+            else if ((am == 0xfe && am_dist > 4 && am_dist <= 6) ||
+                (am == 0xfb && am_dist > data_size&& am_dist <= (data_size + 2)))
+            {
+                colours.push_back(colour::MAGENTA);
             }
             else
             {
-                if (am == 0xfe && am_dist == 4)
-                    data_size = Sector::SizeCodeToLength(b);
-
-                if (a1 == 3)
-                {
-                    colours.push_back(colour::RED);
-                    am = b;
-                    am_dist = 0;
-                }
-                else if (encoding == Encoding::FM && found_am)
-                {
-                    colours.push_back((bits == 32) ? colour::RED : colour::red);
-                    am = b;
-                    am_dist = 0;
-                }
-                else if (am == 0xfe && am_dist >= 1 && am_dist <= 4)
-                {
-                    colours.push_back((am_dist == 3) ? colour::GREEN : colour::green);
-                }
-                else if (am == 0xfb && am_dist >= 1 && am_dist <= data_size)
-                {
-                    colours.push_back(colour::white);
-                }
-                else if ((am == 0xfe && am_dist > 4 && am_dist <= 6) ||
-                    (am == 0xfb && am_dist > data_size&& am_dist <= (data_size + 2)))
-                {
-                    colours.push_back(colour::MAGENTA);
-                }
-                else
-                {
-                    colours.push_back(colour::grey);
-                }
-
-                a1 = 0;
+                colours.push_back(colour::grey);
             }
 
-            bits = 0;
+            a1 = 0;
         }
+
+        bits = 0;
     }
 
     auto show_begin = std::max(opt.bytes_begin, 0);
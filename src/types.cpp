@@ -5,6 +5,7 @@
 #ifdef DECLARATIONS_ONLY
 
 extern IMAGE_ENTRY aImageTypes[];
+extern IMAGE_SIGNATURE aImageSignatures[];
 extern DEVICE_ENTRY aDeviceTypes[];
 
 #define ADD_IMAGE_RW(x)     bool Read##x (MemFile&, std::shared_ptr<Disk> &); \
@@ -13,6 +14,8 @@ extern DEVICE_ENTRY aDeviceTypes[];
 #define ADD_IMAGE_WO(x)     bool Write##x (FILE*,   std::shared_ptr<Disk> &);
 #define ADD_IMAGE_HIDDEN_RO(x)  bool Read##x (MemFile&, std::shared_ptr<Disk> &);
 
+#define ADD_SIGNATURE(x, offset, sig)
+
 #define ADD_DEVICE(x)       bool Read##x (const std::string &, std::shared_ptr<Disk> &); \
                             bool Write##x (const std::string &, std::shared_ptr<Disk> &);
 #else
@@ -24,6 +27,8 @@ extern DEVICE_ENTRY aDeviceTypes[];
 #define ADD_IMAGE_WO(x)     { #x, nullptr, Write##x },
 #define ADD_IMAGE_HIDDEN_RO(x)  { "", Read##x, nullptr },
 
+#define ADD_SIGNATURE(x, offset, sig)   { Read##x, offset, sig, sizeof(sig) - 1 },
+
 #define ADD_DEVICE(x)       { #x, Read##x, Write##x },
 
 IMAGE_ENTRY aImageTypes[] = {
@@ -93,6 +98,51 @@ IMAGE_ENTRY aImageTypes[] = {
 #endif
 
 
+#ifndef DECLARATIONS_ONLY
+
+// Types listed here are only offered images holding one of their signatures.
+// A leading part of a longer signature is enough to rule out other images.
+IMAGE_SIGNATURE aImageSignatures[] = {
+
+#endif
+
+ADD_SIGNATURE(DSK, 0, "MV - CPC")
+ADD_SIGNATURE(DSK, 0, "EXTENDED")
+ADD_SIGNATURE(TD0, 0, "TD")
+ADD_SIGNATURE(TD0, 0, "td")
+ADD_SIGNATURE(SAD, 0, "Aley's disk backup")
+ADD_SIGNATURE(SCL, 0, "SINCLAIR")
+ADD_SIGNATURE(FDI, 0, "FDI")
+ADD_SIGNATURE(DTI, 0, "H2G2")
+ADD_SIGNATURE(IPF, 0, "CAPS")
+ADD_SIGNATURE(MSA, 0, "\x0e\x0f")
+ADD_SIGNATURE(CQM, 0, "CQ\x14")
+ADD_SIGNATURE(CWTOOL, 0, "cwtool raw data")
+ADD_SIGNATURE(UDI, 0, "UDI")
+ADD_SIGNATURE(UDI, 0, "udi!")
+ADD_SIGNATURE(IMD, 0, "IMD ")
+ADD_SIGNATURE(DFI, 0, "DFER")
+ADD_SIGNATURE(DFI, 0, "DFE2")
+ADD_SIGNATURE(SCP, 0, "SCP")
+ADD_SIGNATURE(STREAM, 0, "\x0d")
+ADD_SIGNATURE(HFE, 0, "HXCPICFE")
+ADD_SIGNATURE(MFI, 0, "MESSFLOPPYIMAGE")
+ADD_SIGNATURE(QDOS, 0, "QL5A")
+ADD_SIGNATURE(QDOS, 0, "QL5B")
+ADD_SIGNATURE(SAP, 1, "SYSTEME D'ARCHIVAGE PUKALL")
+ADD_SIGNATURE(WOZ, 0, "WOZ1")
+ADD_SIGNATURE(PDI, 0, "PDITYPE")
+ADD_SIGNATURE(A2R, 0, "A2R2")
+ADD_SIGNATURE(D80, 204, "SDOS")
+
+#ifndef DECLARATIONS_ONLY
+{
+    nullptr, 0, nullptr, 0
+}   // aImageSignatures list terminator
+};
+#endif
+
+
 #ifndef DECLARATIONS_ONLY
 
 DEVICE_ENTRY aDeviceTypes[] = {
@@ -124,4 +174,6 @@ ADD_DEVICE(FdrawcmdSysAB)
 #undef ADD_IMAGE_WO
 #undef ADD_IMAGE_HIDDEN_RO
 
+#undef ADD_SIGNATURE
+
 #undef ADD_DEVICE
@@ -64,10 +64,14 @@ public:
 protected:
     TrackData load(const CylHead& cylhead, bool /*first_read*/) override
     {
-        const auto& data = m_data[cylhead];
-        if (data.empty())
+        // Look up without inserting, as other tracks may be loading concurrently.
+        auto it = m_data.find(cylhead);
+        if (it == m_data.end() || it->second.empty())
             return TrackData(cylhead);
 
+        const auto& data = it->second;
+        auto loop_point = m_loop_point.at(cylhead);
+
         FluxData flux_revs;
 
         std::vector<uint32_t> flux_times;
@@ -83,18 +87,18 @@ protected:
                 ticks += total_time;
                 total_time = 0;
 
-                if (ticks >= m_loop_point[cylhead])
+                if (ticks >= loop_point)
                 {
                     flux_revs.push_back(std::move(flux_times));
                     flux_times.clear();
-                    ticks -= m_loop_point[cylhead];
+                    ticks -= loop_point;
                 }
             }
         }
 
         flux_revs.push_back(std::move(flux_times));
 
-        m_data[cylhead].clear();
+        std::vector<uint8_t>().swap(it->second);
 
         return TrackData(cylhead, std::move(flux_revs));
     }
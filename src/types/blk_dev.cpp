@@ -54,7 +54,7 @@ protected:
         return TrackData(cylhead, std::move(track));
     }
 
-    bool preload(const Range&/*range*/, int /*cyl_step*/) override
+    bool supports_concurrent_reads() const override
     {
         return false;
     }
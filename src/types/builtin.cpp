@@ -1134,7 +1134,7 @@ bool ReadBuiltIn(const std::string& path, std::shared_ptr<Disk>& disk)
             iota(weak_data, 0);
             track[1].add(Data(weak_data), true);
             auto trackdata = GenerateSpectrumSpeedlockTrack(cylhead.next_cyl(), track, 0, 512);
-            disk->write(trackdata.cylhead, FluxData(trackdata.flux()), true);
+            disk->write(trackdata.cylhead, trackdata.flux().expand(), true);
 
             // Part weak sector.
             track[1].remove_data();
@@ -1143,7 +1143,7 @@ bool ReadBuiltIn(const std::string& path, std::shared_ptr<Disk>& disk)
             fill(weak_data, 256 + 32, 256 + 32 + 48, 2);
             track[1].add(Data(weak_data), true);
             trackdata = GenerateSpectrumSpeedlockTrack(cylhead.next_cyl(), track, 336, 32);
-            disk->write(trackdata.cylhead, FluxData(trackdata.flux()), true);
+            disk->write(trackdata.cylhead, trackdata.flux().expand(), true);
         }
 
         // Amstrad CPC Speedlock weak sectors (full, half, and part).
@@ -1170,7 +1170,7 @@ bool ReadBuiltIn(const std::string& path, std::shared_ptr<Disk>& disk)
             iota(weak_data, 0);
             track[7].add(Data(weak_data), true);
             auto trackdata = GenerateCpcSpeedlockTrack(cylhead.next_cyl(), track, 0, 512);
-            disk->write(trackdata.cylhead, FluxData(trackdata.flux()), true);
+            disk->write(trackdata.cylhead, trackdata.flux().expand(), true);
 
             // Half weak sector.
             track[0].datas()[0][129] = 'S';
@@ -1179,7 +1179,7 @@ bool ReadBuiltIn(const std::string& path, std::shared_ptr<Disk>& disk)
             iota(weak_data, 256, 1);
             track[7].add(Data(weak_data), true);
             trackdata = GenerateCpcSpeedlockTrack(cylhead.next_cyl(), track, 256, 256);
-            disk->write(trackdata.cylhead, FluxData(trackdata.flux()), true);
+            disk->write(trackdata.cylhead, trackdata.flux().expand(), true);
 
             // Part weak sector.
             track[0].datas()[0][129] = 0;
@@ -1189,7 +1189,7 @@ bool ReadBuiltIn(const std::string& path, std::shared_ptr<Disk>& disk)
             fill(weak_data, 256 + 32, 256 + 32 + 48, 2);
             track[7].add(Data(weak_data), true);
             trackdata = GenerateCpcSpeedlockTrack(cylhead.next_cyl(), track, 336, 32);
-            disk->write(trackdata.cylhead, FluxData(trackdata.flux()), true);
+            disk->write(trackdata.cylhead, trackdata.flux().expand(), true);
         }
 
         // Rainbow Arts weak sector.
@@ -58,6 +58,8 @@ static std::string FormatTime(int dos_date, int dos_time)
     return ss.str();
 }
 
+// CopyQM indexes only 64 entries of the CRC-32 table, so its checksum
+// can't use the standard CRC32.
 static uint32_t crc32(const uint8_t* buf, int len, uint32_t crc = 0)
 {
     static std::vector<uint32_t> crc_table(0x40);   // 6-bit
@@ -89,7 +91,7 @@ bool ReadCQM(MemFile& file, std::shared_ptr<Disk>& disk)
         return false;
 
     auto header_checksum = std::accumulate(
-        file.data().begin(), file.data().begin() + sizeof(dh), 0);
+        file.bytes(), file.bytes() + sizeof(dh), 0);
     if (header_checksum & 0xff)
         throw util::exception("bad header checksum");
 
@@ -57,10 +57,13 @@ public:
 protected:
     TrackData load(const CylHead& cylhead, bool /*first_read*/) override
     {
-        const auto& data = m_data[cylhead];
-        if (data.empty())
+        // Look up without inserting, as other tracks may be loading concurrently.
+        auto it = m_data.find(cylhead);
+        if (it == m_data.end() || it->second.empty())
             return TrackData(cylhead);
 
+        const auto& data = it->second;
+
         FluxData flux_revs;
         std::vector<uint32_t> flux_times;
         flux_times.reserve(data.size());
@@ -89,7 +92,7 @@ protected:
         if (!flux_times.empty())
             flux_revs.push_back(std::move(flux_times));
 
-        m_data.erase(cylhead);
+        Data().swap(it->second);
         return TrackData(cylhead, std::move(flux_revs));
     }
 
@@ -410,7 +410,7 @@ bool ReadDSK(MemFile& file, std::shared_ptr<Disk>& disk)
     size_t uTail = file.size() - file.tell();
     if (uTail)
     {
-        auto pbTail = file.data().data() + file.tell();
+        auto pbTail = file.bytes() + file.tell();
 
         if (!memcmp(pbTail, pbTail + 1, uTail - 1))
         {
@@ -421,7 +421,7 @@ bool ReadDSK(MemFile& file, std::shared_ptr<Disk>& disk)
         {
             // Example: Silva (1985)(Lankhor)(fr)[cr Genesis][t Genesis].zip (TOSEC CPC Games)
             Message(msgWarning, "%u bytes of unused data found at end of file:", uTail);
-            util::hex_dump(file.data().begin(), file.data().end(), file.tell());
+            util::hex_dump(file.bytes(), file.bytes() + file.size(), file.tell());
         }
     }
 
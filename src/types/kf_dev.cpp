@@ -33,7 +33,7 @@ public:
 protected:
     TrackData load(const CylHead& cylhead, bool first_read) override
     {
-        FluxData flux_revs;
+        CompactFlux flux_revs;
         auto revs = first_read ? FIRST_READ_REVS : REMAIN_READ_REVS;
 
         m_kryoflux->EnableMotor(1);
@@ -42,14 +42,17 @@ protected:
         m_kryoflux->SelectSide(cylhead.head);
 
         std::vector<std::string> warnings;
-        m_kryoflux->ReadFlux(revs + 1, flux_revs, warnings);
+        // Pack each revolution as it arrives, overlapping capture of the next.
+        m_kryoflux->ReadFlux(revs + 1, [&](std::vector<uint32_t>&& flux_times) {
+            flux_revs.add(flux_times);
+            }, warnings);
         for (auto& w : warnings)
             Message(msgWarning, "%s on %s", w.c_str(), CH(cylhead.cyl, cylhead.head));
 
         return TrackData(cylhead, std::move(flux_revs));
     }
 
-    bool preload(const Range&/*range*/, int /*cyl_step*/) override
+    bool supports_concurrent_reads() const override
     {
         return false;
     }
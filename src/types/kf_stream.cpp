@@ -3,7 +3,35 @@
 
 #include "SAMdisk.h"
 #include "KryoFlux.h"
+#include "ThreadPool.h"
 
+// A track file, decoded independently of the others.
+struct STREAM_TRACK
+{
+    CylHead cylhead{};
+    std::string path{};
+    bool valid = false;
+    CompactFlux flux{};
+    std::vector<std::string> warnings{};
+};
+
+static void DecodeTrackFile(STREAM_TRACK& track)
+{
+    // Unreadable files count as missing or invalid tracks.
+    try
+    {
+        MemFile file;
+        file.open(track.path);
+
+        auto flux_revs = KryoFlux::DecodeStream(file.bytes(), file.size(), track.warnings);
+        track.flux = CompactFlux(flux_revs);
+        track.valid = true;
+    }
+    catch (...)
+    {
+        track.warnings.clear();
+    }
+}
 
 bool ReadSTREAM(MemFile& file, std::shared_ptr<Disk>& disk)
 {
@@ -23,13 +51,65 @@ bool ReadSTREAM(MemFile& file, std::shared_ptr<Disk>& disk)
     auto ext = path.substr(len - 3);
     path = path.substr(0, len - 8);
 
-    auto missing0 = 0, missing1 = 0, missing_total = 0;
+    // List the directory once rather than probing for each track file.
+    // Names are matched exactly, falling back on a match without case.
+    auto sep = path.rfind(PATH_SEPARATOR_CHR);
+    auto dir = (sep == path.npos) ? std::string(".") : path.substr(0, sep ? sep : 1);
+    auto prefix = (sep == path.npos) ? std::string() : path.substr(0, sep + 1);
 
+    std::set<std::string> dir_names;
+    std::map<std::string, std::string> lower_names;
+    for (auto& name : ListDir(dir))
+    {
+        dir_names.insert(name);
+        lower_names.emplace(util::lowercase(name), name);
+    }
+
+    std::vector<STREAM_TRACK> tracks;
     Range(MAX_TRACKS, MAX_SIDES).each([&](const CylHead& cylhead) {
         auto track_path = util::fmt("%s%02u.%u.%s", path.c_str(), cylhead.cyl, cylhead.head, ext.c_str());
 
-        MemFile f;
-        if (!IsFile(track_path) || !f.open(track_path))
+        if (!dir_names.empty() && !dir_names.count(track_path.substr(prefix.length())))
+        {
+            auto it = lower_names.find(util::lowercase(track_path.substr(prefix.length())));
+            track_path = (it == lower_names.end()) ? "" : prefix + it->second;
+        }
+
+        if (!track_path.empty() && IsFile(track_path))
+        {
+            STREAM_TRACK track;
+            track.cylhead = cylhead;
+            track.path = track_path;
+            tracks.push_back(std::move(track));
+        }
+        });
+
+    // Decode the track files in parallel, if we can.
+    if (opt.mt && ThreadPool::get_thread_count() > 1 && tracks.size() > 1)
+    {
+        ThreadPool pool;
+        std::vector<std::future<void>> rets;
+
+        for (auto& track : tracks)
+            rets.push_back(pool.enqueue(DecodeTrackFile, std::ref(track)));
+
+        for (auto& ret : rets)
+            ret.get();
+    }
+    else
+    {
+        for (auto& track : tracks)
+            DecodeTrackFile(track);
+    }
+
+    auto missing0 = 0, missing1 = 0, missing_total = 0;
+    auto it = tracks.begin();
+
+    Range(MAX_TRACKS, MAX_SIDES).each([&](const CylHead& cylhead) {
+        auto found = it != tracks.end() && it->cylhead == cylhead;
+        auto track = found ? &*it++ : nullptr;
+
+        if (!track || !track->valid)
         {
             missing0 += (cylhead.head == 0);
             missing1 += (cylhead.head == 1);
@@ -48,12 +128,10 @@ bool ReadSTREAM(MemFile& file, std::shared_ptr<Disk>& disk)
                 missing1 = 0;
             }
 
-            std::vector<std::string> warnings;
-            auto flux_revs = KryoFlux::DecodeStream(f.data(), warnings);
-            for (auto& w : warnings)
+            for (auto& w : track->warnings)
                 Message(msgWarning, "%s on %s", w.c_str(), CH(cylhead.cyl, cylhead.head));
 
-            disk->write(cylhead, std::move(flux_revs));
+            disk->write(TrackData(cylhead, std::move(track->flux)));
         }
         });
 
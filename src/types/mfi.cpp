@@ -5,6 +5,7 @@
 #include "SAMdisk.h"
 #include "DemandDisk.h"
 #include "BitstreamDecoder.h"
+#include "ThreadPool.h"
 
 #ifdef HAVE_ZLIB
 #include "zlib.h"
@@ -58,30 +59,45 @@ enum {
 };
 
 
+#ifdef HAVE_ZLIB
 class MFIDisk final : public DemandDisk
 {
 public:
-    void add_track_data(const CylHead& cylhead, std::vector<uint32_t>&& trackdata)
+    explicit MFIDisk(const MemFile& file) : m_file(file) {}
+
+    void add_track_header(const CylHead& cylhead, const MFI_TRACK_HEADER& th)
     {
-        m_data[cylhead] = std::move(trackdata);
+        m_tracks[cylhead] = th;
         extend(cylhead);
     }
 
 protected:
+    // Tracks are decompressed as they're loaded, which preload() spreads
+    // across threads. The track map is complete before loading begins.
     TrackData load(const CylHead& cylhead, bool /*first_read*/) override
     {
-        const auto& data = m_data[cylhead];
-        if (data.empty())
+        auto it = m_tracks.find(cylhead);
+        if (it == m_tracks.end())
             return TrackData(cylhead);
 
-        FluxData flux_revs;
+        auto& th = it->second;
+        std::vector<uint32_t> track_data(th.uncompressed_size >> 2);
+        if (track_data.empty())
+            return TrackData(cylhead);
+
+        auto size = static_cast<uLongf>(track_data.size() * sizeof(track_data[0]));
+        int rc = uncompress(reinterpret_cast<Bytef*>(track_data.data()), &size,
+            m_file.bytes() + th.offset, th.compressed_size);
+        if (rc != Z_OK)
+            throw util::exception("decompress of ", cylhead, " failed, rc ", rc);
 
         std::vector<uint32_t> flux_times;
-        flux_times.reserve(data.size());
+        flux_times.reserve(track_data.size());
 
         uint32_t total_time = 0;
-        for (auto time : data)
+        for (auto time : track_data)
         {
+            time = util::letoh(time) & TIME_MASK;
             flux_times.push_back(time);
             total_time += time;
         }
@@ -89,19 +105,17 @@ protected:
         if (total_time != 200000000)
             throw util::exception("wrong total_time for ", cylhead, ": ", total_time);
 
-        if (!flux_times.empty())
-            flux_revs.push_back(std::move(flux_times));
-
-        // causes random crashes
-        //  m_data.erase(cylhead);
+        FluxData flux_revs;
+        flux_revs.push_back(std::move(flux_times));
 
         return TrackData(cylhead, std::move(flux_revs));
     }
 
 private:
-    std::map<CylHead, std::vector<uint32_t>> m_data{};
-
+    MemFile m_file;
+    std::map<CylHead, MFI_TRACK_HEADER> m_tracks{};     // host byte order
 };
+#endif // HAVE_ZLIB
 
 
 bool ReadMFI(MemFile& file, std::shared_ptr<Disk>& disk)
@@ -123,7 +137,7 @@ bool ReadMFI(MemFile& file, std::shared_ptr<Disk>& disk)
     if ((fh.cyl_count & CYLINDER_MASK) > 84 || fh.head_count > 2)
         return false;
 
-    auto mfi_disk = std::make_shared<MFIDisk>();
+    auto mfi_disk = std::make_shared<MFIDisk>(file);
 
     fh.cyl_count &= CYLINDER_MASK;
 
@@ -136,31 +150,15 @@ bool ReadMFI(MemFile& file, std::shared_ptr<Disk>& disk)
                 break;
 
             CylHead cylhead(cyl, head);
+            th.offset = util::letoh(th.offset);
+            th.compressed_size = util::letoh(th.compressed_size);
+            th.uncompressed_size = util::letoh(th.uncompressed_size);
 
-            Data compressed_data(util::letoh(th.compressed_size));
-            std::vector<uint32_t> track_data(util::letoh(th.uncompressed_size) >> 2);
-
-            auto o = file.tell();
-            file.seek(util::letoh(th.offset));
-            if (!file.read(compressed_data))
+            if (th.offset > static_cast<uint32_t>(file.size()) ||
+                th.compressed_size > static_cast<uint32_t>(file.size()) - th.offset)
                 throw util::exception("short file reading ", cylhead, " data");
 
-            file.seek(o);
-
-            uLongf size = util::letoh(th.uncompressed_size);
-            int rc = uncompress((Bytef*)&track_data[0], &size, &compressed_data[0], util::letoh(th.compressed_size));
-            if (rc != Z_OK)
-            {
-                util::cout << "decompress of " << cylhead << " failed, rc " << rc << "\n";
-                util::cout << "sizes " << util::letoh(th.compressed_size) << " to " << util::letoh(th.uncompressed_size) << "\n";
-                return false;
-            }
-
-            // XXX redo
-            std::transform(track_data.begin(), track_data.end(), track_data.begin(),
-                [](uint32_t c) -> uint32_t { return (util::letoh(c) & TIME_MASK); });
-
-            mfi_disk->add_track_data(cylhead, std::move(track_data));
+            mfi_disk->add_track_header(cylhead, th);
         }
     }
 
@@ -226,94 +224,106 @@ bool WriteMFI(FILE* f_, std::shared_ptr<Disk>& disk)
     fh.form_factor = util::htole(FF_UNKNOWN);
     fh.variant = util::htole(MfiVariant(track0, disk->cyls(), disk->heads()));
 
-    if (!fwrite(header.data(), header.size(), 1, f_))
-        throw util::exception("write error");
+    struct MFI_TRACK
+    {
+        Data compressed_data{};
+        uint32_t uncompressed_size = 0;
+    };
+
+    auto compress_track = [&](const CylHead& cylhead) -> MFI_TRACK {
+        auto trackdata = disk->read(cylhead);
+        auto bitstream = trackdata.preferred().flux().expand();
+        int orient = 0;
+        unsigned int total_sum = 0;
+
+        std::vector<uint32_t> track_data(bitstream[0].size());
+        track_data.reserve(track_data.size() + 1);
+
+        std::transform(bitstream[0].begin(), bitstream[0].end(), track_data.begin(),
+            [&orient, &total_sum](uint32_t a) -> uint32_t {
+                orient ^= 1; total_sum += a; return (a) | (orient ? MG_B : MG_A);
+            });
+
+        // Normalize the times in a cell buffer to sum up to 200000000
+        unsigned int current_sum = 0;
+        for (unsigned int i = 0; i != track_data.size(); i++) {
+            uint32_t time = track_data[i] & TIME_MASK;
+            track_data[i] = (track_data[i] & MG_MASK) | (200000000ULL * time / total_sum);
+            current_sum += (track_data[i] & TIME_MASK);
+        }
 
-    std::map<CylHead, MFI_TRACK_HEADER> track_lut;
-    std::map<CylHead, FluxData> bitstreams;
-    int pos = sizeof(MFI_FILE_HEADER) + tracks * heads * sizeof(MFI_TRACK_HEADER);
+        if (current_sum < 200000000)
+        {
+            track_data.push_back((200000000 - current_sum) | (orient ? MG_B : MG_A));
+        }
+
+        std::transform(track_data.begin(), track_data.end(), track_data.begin(),
+            [](uint32_t c) -> uint32_t { return util::htole(c); });
+
+        MFI_TRACK mfi_track;
+        mfi_track.uncompressed_size = static_cast<uint32_t>(track_data.size() * sizeof(track_data[0]));
 
-    if (fseek(f_, pos, SEEK_SET) < 0)
-        throw util::exception("seek error");
+        auto csize = compressBound(mfi_track.uncompressed_size);
+        mfi_track.compressed_data.resize(csize);
 
-    //
+        int rc = compress2(mfi_track.compressed_data.data(), &csize,
+            reinterpret_cast<const Bytef*>(track_data.data()), mfi_track.uncompressed_size, opt.complevel);
+        if (rc != Z_OK)
+            throw util::exception("compress of ", cylhead, " failed, rc ", rc);
 
-    auto max_disk_track_bytes = 0;
+        mfi_track.compressed_data.resize(csize);
+        return mfi_track;
+    };
+
+    // Tracks are converted and compressed concurrently, if the disk allows
+    // it, then written in order once their offsets are known.
+    std::vector<CylHead> cylheads;
     for (int cyl = 0; cyl < tracks; ++cyl)
-    {
-        auto max_track_bytes = 0;
         for (int head = 0; head < heads; ++head)
-        {
-            CylHead cylhead(cyl, head);
-            auto trackdata = disk->read(cylhead);
-            auto bitstream = trackdata.preferred().flux();
-            auto track_bytes = static_cast<int>(bitstream[0].size() * 4);
-            max_track_bytes = std::max(track_bytes, max_track_bytes);
-            max_disk_track_bytes = std::max(max_disk_track_bytes, max_track_bytes);
-            bitstreams[cylhead] = std::move(bitstream);
-        }
-    }
+            cylheads.emplace_back(cyl, head);
 
-    for (int cyl = 0; cyl < tracks; ++cyl)
+    std::vector<MFI_TRACK> mfi_tracks;
+    mfi_tracks.reserve(cylheads.size());
+
+    if (opt.mt && ThreadPool::get_thread_count() > 1 && disk->supports_concurrent_reads())
     {
-        for (int head = 0; head < heads; ++head)
-        {
-            CylHead cylhead(cyl, head);
-            auto& bitstream = bitstreams[cylhead];
-            auto track_size = bitstream[0].size() + 1;
-            int orient = 0;
-            unsigned int total_sum = 0;
-
-            std::vector<uint32_t> track_data(track_size - 1);
-            Data compressed_data(track_size * 4 + 1000);
-
-            std::transform(bitstream[0].begin(), bitstream[0].end(), track_data.begin(),
-                [&orient, &total_sum](uint32_t a) -> uint32_t {
-                    orient ^= 1; total_sum += a; return (a) | (orient ? MG_B : MG_A);
-                });
-
-            // Normalize the times in a cell buffer to sum up to 200000000
-            unsigned int current_sum = 0;
-            for (unsigned int i = 0; i != track_data.size(); i++) {
-                uint32_t time = track_data[i] & TIME_MASK;
-                track_data[i] = (track_data[i] & MG_MASK) | (200000000ULL * time / total_sum);
-                current_sum += (track_data[i] & TIME_MASK);
-            }
+        ThreadPool pool;
+        std::vector<std::future<MFI_TRACK>> rets;
 
-            if (current_sum < 200000000)
-            {
-                track_data.push_back((200000000 - current_sum) | (orient ? MG_B : MG_A));
-            }
+        for (auto& cylhead : cylheads)
+            rets.push_back(pool.enqueue(compress_track, cylhead));
 
-            auto csize = static_cast<uLongf>(track_size * 4 + 1000);
-            int rc = compress(&compressed_data[0], &csize, (const Bytef*)&track_data[0], static_cast<uLongf>(track_size * 4));
-            if (rc != Z_OK) {
-                util::cout << "compress of " << CylHead(cyl, head) << " failed, rc " << rc << "\n";
-                return false;
-            }
+        for (auto& ret : rets)
+            mfi_tracks.push_back(ret.get());
+    }
+    else
+    {
+        for (auto& cylhead : cylheads)
+            mfi_tracks.push_back(compress_track(cylhead));
+    }
 
-            track_lut[cylhead] = {
-                util::htole(static_cast<uint32_t>(pos)),
-                util::htole(static_cast<uint32_t>(csize)),
-                util::htole(static_cast<uint32_t>(track_size * 4)),
-                0 };
+    std::vector<MFI_TRACK_HEADER> track_lut;
+    auto pos = static_cast<uint32_t>(sizeof(MFI_FILE_HEADER) + cylheads.size() * sizeof(MFI_TRACK_HEADER));
 
-            if (!fwrite(compressed_data.data(), csize, 1, f_))
-                throw util::exception("write error");
-            pos += csize;
-        }
+    for (auto& mfi_track : mfi_tracks)
+    {
+        auto csize = static_cast<uint32_t>(mfi_track.compressed_data.size());
+        track_lut.push_back({
+            util::htole(pos),
+            util::htole(csize),
+            util::htole(mfi_track.uncompressed_size),
+            0 });
+        pos += csize;
     }
 
-    if (fseek(f_, sizeof(MFI_FILE_HEADER), SEEK_SET) < 0)
-        throw util::exception("seek error");
+    if (!fwrite(header.data(), header.size(), 1, f_) ||
+        (!track_lut.empty() && !fwrite(track_lut.data(), sizeof(MFI_TRACK_HEADER), track_lut.size(), f_)))
+        throw util::exception("write error");
 
-    for (int cyl = 0; cyl < tracks; ++cyl)
+    for (auto& mfi_track : mfi_tracks)
     {
-        for (int head = 0; head < heads; ++head)
-        {
-            if (!fwrite(&track_lut[{cyl, head}], sizeof(MFI_TRACK_HEADER), 1, f_))
-                throw util::exception("write error");
-        }
+        if (!fwrite(mfi_track.compressed_data.data(), mfi_track.compressed_data.size(), 1, f_))
+            throw util::exception("write error");
     }
 
     return true;
@@ -96,39 +96,88 @@ std::string FooterTime(uint64_t unix_time)
 }
 
 
+// Location of a track's flux data within the file.
+struct SCP_TRACK_EXTENT
+{
+    uint32_t begin = 0, end = 0;                        // track header to end of data
+    std::vector<std::pair<uint32_t, uint32_t>> revs{};  // offset and count of each revolution
+    bool summed = false;                                // included in the file checksum yet?
+};
+
 class SCPDisk final : public DemandDisk
 {
 public:
-    SCPDisk(bool normalised) : m_normalised(normalised) {}
+    SCPDisk(const MemFile& file, bool normalised) : m_file(file), m_normalised(normalised) {}
 
-    void add_track_data(const CylHead& cylhead, std::vector<std::vector<uint16_t>>&& trackdata)
+    void add_track_extent(const CylHead& cylhead, SCP_TRACK_EXTENT&& extent)
     {
-        m_data[cylhead] = std::move(trackdata);
+        m_tracks[cylhead] = std::move(extent);
         extend(cylhead);
     }
 
+    ~SCPDisk()
+    {
+        // Add any tracks that weren't loaded, so the checksum is always verified.
+        if (m_verify_checksum)
+        {
+            auto pb = m_file.bytes();
+            for (auto& track : m_tracks)
+            {
+                auto& extent = track.second;
+                if (!extent.summed)
+                    m_checksum += std::accumulate(pb + extent.begin, pb + extent.end, uint32_t(0));
+            }
+
+            if (m_checksum != m_expected_checksum)
+                Message(msgWarning, "file checksum is incorrect!");
+        }
+    }
+
+    // Verify the file checksum as tracks are loaded, starting from the sum of
+    // the bytes outside the track extents. The rest is summed and the result
+    // reported when the disk is closed.
+    void verify_checksum(uint32_t expected, uint32_t partial_sum)
+    {
+        m_expected_checksum = expected;
+        m_checksum = partial_sum;
+        m_verify_checksum = true;
+    }
+
 protected:
     TrackData load(const CylHead& cylhead, bool /*first_read*/) override
     {
         FluxData flux_revs;
 
-        auto it = m_data.find(cylhead);
-        if (it == m_data.end())
+        // The track map is complete before loading begins, and each extent
+        // is only changed under the lock of its own track slot.
+        auto it = m_tracks.find(cylhead);
+        if (it == m_tracks.end())
             return TrackData(cylhead);
 
-        for (auto& rev_times : it->second)
+        auto& extent = it->second;
+        auto pb = m_file.bytes();
+
+        if (m_verify_checksum && !extent.summed)
+        {
+            extent.summed = true;
+            m_checksum += std::accumulate(pb + extent.begin, pb + extent.end, uint32_t(0));
+        }
+
+        for (auto& rev : extent.revs)
         {
             std::vector<uint32_t> flux_times;
-            flux_times.reserve(rev_times.size());
+            flux_times.reserve(rev.second);
 
             uint32_t total_time = 0;
-            for (auto time : rev_times) // note: big endian times!
+            auto p = pb + rev.first;
+            for (uint32_t i = 0; i < rev.second; ++i, p += 2)
             {
+                uint32_t time = (p[0] << 8) | p[1]; // note: big endian times!
                 if (!time)
                     total_time += 0x10000;
                 else
                 {
-                    total_time += util::betoh(time);
+                    total_time += time;
                     flux_times.push_back(total_time * 25);  // 25ns sampling time
                     total_time = 0;
                 }
@@ -141,8 +190,13 @@ protected:
     }
 
 private:
-    std::map<CylHead, std::vector<std::vector<uint16_t>>> m_data{};
+    MemFile m_file;
+    std::map<CylHead, SCP_TRACK_EXTENT> m_tracks{};
     bool m_normalised = false;
+
+    uint32_t m_expected_checksum = 0;
+    std::atomic<uint32_t> m_checksum{ 0 };
+    bool m_verify_checksum = false;
 };
 
 bool ReadSCP(MemFile& file, std::shared_ptr<Disk>& disk)
@@ -152,13 +206,6 @@ bool ReadSCP(MemFile& file, std::shared_ptr<Disk>& disk)
     if (!file.rewind() || !file.read(&fh, sizeof(fh)) || std::string(fh.signature, 3) != "SCP")
         return false;
 
-    if (!(fh.flags & FLAG_MODE) && fh.checksum)
-    {
-        auto checksum = std::accumulate(file.data().begin() + STANDARD_TDH_OFFSET, file.data().end(), uint32_t(0));
-        if (checksum != util::letoh(fh.checksum))
-            Message(msgWarning, "file checksum is incorrect!");
-    }
-
     /*if (!(fh.flags & FLAG_INDEX))
         throw util::exception("not an index-synchronised image");
     else*/ if (fh.flags & FLAG_EXTENDED)
@@ -203,7 +250,9 @@ bool ReadSCP(MemFile& file, std::shared_ptr<Disk>& disk)
         }
     }
 
-    auto scp_disk = std::make_shared<SCPDisk>((fh.flags & FLAG_TYPE) != 0);
+    auto scp_disk = std::make_shared<SCPDisk>(file, (fh.flags & FLAG_TYPE) != 0);
+    std::vector<std::pair<uint32_t, uint32_t>> track_extents;
+    auto data_end = file.tell();
 
     for (int tracknr = 0; tracknr < static_cast<int>(tdh_offsets.size()); ++tracknr)
     {
@@ -224,8 +273,11 @@ bool ReadSCP(MemFile& file, std::shared_ptr<Disk>& disk)
         if (!file.read(rev_index))
             throw util::exception("short file reading ", cylhead, " track index");
 
-        std::vector<std::vector<uint16_t>> revs_data;
-        revs_data.reserve(fh.revolutions);
+        // Only the flux data locations are kept, to be read on demand.
+        SCP_TRACK_EXTENT extent;
+        extent.begin = tdh_offsets[tracknr];
+        extent.end = static_cast<uint32_t>(file.tell());
+        extent.revs.reserve(fh.revolutions);
 
         for (uint8_t rev = 0; rev < fh.revolutions; ++rev)
         {
@@ -233,16 +285,56 @@ bool ReadSCP(MemFile& file, std::shared_ptr<Disk>& disk)
             auto flux_count = util::letoh<uint32_t>(rev_index[rev * 3 + 1]);
             auto data_offset = util::letoh<uint32_t>(rev_index[rev * 3 + 2]);
 
-            std::vector<uint16_t> flux_data(flux_count);
-            if (!file.seek(tdh_offsets[tracknr] + data_offset) || !file.read(flux_data))
+            auto offset = static_cast<uint64_t>(tdh_offsets[tracknr]) + data_offset;
+            if (offset + flux_count * uint64_t(2) > static_cast<uint64_t>(file.size()))
                 throw util::exception("short error reading ", cylhead, " data");
 
-            revs_data.push_back(std::move(flux_data));
+            extent.revs.emplace_back(static_cast<uint32_t>(offset), flux_count);
+            extent.end = std::max(extent.end, static_cast<uint32_t>(offset + flux_count * 2));
+            data_end = static_cast<int>(offset + flux_count * 2);
         }
 
-        scp_disk->add_track_data(cylhead, std::move(revs_data));
+        track_extents.emplace_back(extent.begin, extent.end);
+        scp_disk->add_track_extent(cylhead, std::move(extent));
     }
 
+    if (!(fh.flags & FLAG_MODE) && fh.checksum)
+    {
+        // If the track extents don't overlap, sum the bytes between them now
+        // and leave the rest until each track is loaded. Otherwise sum it all.
+        std::sort(track_extents.begin(), track_extents.end());
+        uint32_t pos = STANDARD_TDH_OFFSET, partial_sum = 0;
+        auto pb = file.bytes();
+        auto disjoint = true;
+
+        for (auto& extent : track_extents)
+        {
+            if (extent.first < pos)
+            {
+                disjoint = false;
+                break;
+            }
+
+            partial_sum = std::accumulate(pb + pos, pb + extent.first, partial_sum);
+            pos = extent.second;
+        }
+
+        if (disjoint && !track_extents.empty())
+        {
+            partial_sum = std::accumulate(pb + pos, pb + file.size(), partial_sum);
+            scp_disk->verify_checksum(util::letoh(fh.checksum), partial_sum);
+        }
+        else
+        {
+            auto checksum = std::accumulate(pb + STANDARD_TDH_OFFSET, pb + file.size(), uint32_t(0));
+            if (checksum != util::letoh(fh.checksum))
+                Message(msgWarning, "file checksum is incorrect!");
+        }
+    }
+
+    // Continue from the end of the last flux data, as if it had been read.
+    file.seek(data_end);
+
     auto footer_offset = file.size() - static_cast<int>(sizeof(SCP_FILE_FOOTER));
     if ((fh.flags & FLAG_FOOTER) && footer_offset >= file.tell())
     {
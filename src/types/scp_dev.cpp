@@ -49,7 +49,7 @@ protected:
         return TrackData(cylhead, std::move(flux_revs));
     }
 
-    bool preload(const Range&/*range*/, int /*cyl_step*/) override
+    bool supports_concurrent_reads() const override
     {
         return false;
     }
@@ -57,7 +57,7 @@ protected:
     void save(TrackData& trackdata) override
     {
         auto preferred = trackdata.preferred();
-        auto& flux_revs = preferred.flux();
+        auto flux_revs = preferred.flux().expand();
         auto flux_times = flux_revs[0];
 
         auto& bitstream = preferred.bitstream();
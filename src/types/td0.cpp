@@ -63,7 +63,7 @@ struct TD0_DATA
 // Namespace wrapper for the Huffman decompression code
 namespace LZSS
 {
-int Unpack(MemFile& file, uint8_t* pOut_);
+Data Unpack(MemFile& file);
 }
 
 
@@ -195,11 +195,9 @@ bool ReadTD0(MemFile& file, std::shared_ptr<Disk>& disk)
     // If the file is Huffman compressed, unpack it
     if (th.abSignature[0] == 't')
     {
-        // 3MB should be enough for any TD0 image
-        MEMORY mem(3 * 1024 * 1024);
-        auto uSize = LZSS::Unpack(file, mem);
+        auto data = LZSS::Unpack(file);
         std::string filename = file.name();
-        file.open(mem, uSize, filename);
+        file.open(data.data(), static_cast<int>(data.size()), filename);
 
         disk->metadata["compress"] = "advanced";
     }
@@ -350,25 +348,14 @@ bool ReadTD0(MemFile& file, std::shared_ptr<Disk>& disk)
 
 namespace LZSS
 {
-#define N           4096                    // ring buffer size
-#define F           60                      // lookahead buffer size
-#define THRESHOLD   2                       // match needs to be longer than this for position/length coding
+constexpr int N = 4096;                     // ring buffer size, and so the match window
+constexpr int F = 60;                       // lookahead buffer size
+constexpr int THRESHOLD = 2;                // match needs to be longer than this for position/length coding
 
-#define N_CHAR      (256 - THRESHOLD + F)   // kinds of characters (character code = 0..N_CHAR-1)
-#define T           (N_CHAR * 2 - 1)        // size of table
-#define R           (T - 1)                 // tree root position
-#define MAX_FREQ    0x8000                  // updates tree when root frequency reached this value
-
-
-short parent[T + N_CHAR];                   // parent nodes (0..T-1) and leaf positions (rest)
-short son[T];                               // pointers to child nodes (son[], son[] + 1)
-uint16_t freq[T + 1];                       // frequency table
-
-uint8_t ring_buff[N + F - 1];               // text buffer for match strings
-unsigned r;                                 // Ring buffer position
-
-MemFile* pfile;                             // compressed input file
-unsigned uBits, uBitBuff;                   // buffered bit count and left-aligned bit buffer
+constexpr int N_CHAR = 256 - THRESHOLD + F; // kinds of characters (character code = 0..N_CHAR-1)
+constexpr int T = N_CHAR * 2 - 1;           // size of table
+constexpr int R = T - 1;                    // tree root position
+constexpr int MAX_FREQ = 0x8000;            // updates tree when root frequency reached this value
 
 
 static const uint8_t d_len[] = { 3,3,4,4,4,5,5,5,5,6,6,6,7,7,7,8 };
@@ -394,43 +381,67 @@ static const uint8_t d_code[] =
 };
 
 
-// Initialise the trees and state variables
-void Init()
+
+// Decoder state for a single block, so separate images can be unpacked at once.
+// Input bits are read from a 64-bit register, refilled a byte at a time.
+class Decoder
 {
-    unsigned i;
+public:
+    Decoder(const uint8_t* pb, int len) : m_pb(pb), m_end(pb + len)
+    {
+        Init();
+    }
+
+    Data Unpack();
+
+private:
+    void Init();
+    void RebuildTree();
+    void UpdateTree(int c);
+
+    void Refill();
+    unsigned GetBits(int count);
+    unsigned DecodeChar();
+    unsigned DecodePosition();
 
-    memset(parent, 0, sizeof(parent));
-    memset(son, 0, sizeof(son));
-    memset(freq, 0, sizeof(freq));
-    memset(ring_buff, 0, sizeof(ring_buff));
+    short parent[T + N_CHAR]{};             // parent nodes (0..T-1) and leaf positions (rest)
+    short son[T]{};                         // pointers to child nodes (son[], son[] + 1)
+    uint16_t freq[T + 1]{};                 // frequency table
+
+    const uint8_t* m_pb = nullptr;          // next input byte
+    const uint8_t* m_end = nullptr;         // end of input
+    uint64_t m_bit_buff = 0;                // left-aligned bit buffer
+    int m_bits = 0;                         // buffered bit count
+    uint64_t m_bits_used = 0;               // total bits consumed
+};
 
 
+// Initialise the trees
+void Decoder::Init()
+{
+    int i;
+
     for (i = 0; i < N_CHAR; i++)
     {
         freq[i] = 1;
-        son[i] = i + T;
-        parent[i + T] = i;
+        son[i] = static_cast<short>(i + T);
+        parent[i + T] = static_cast<short>(i);
     }
 
     i = 0;
     for (int j = N_CHAR; j <= R; i += 2, j++)
     {
         freq[j] = freq[i] + freq[i + 1];
-        son[j] = i;
-        parent[i] = parent[i + 1] = j;
+        son[j] = static_cast<short>(i);
+        parent[i] = parent[i + 1] = static_cast<short>(j);
     }
 
-    uBitBuff = uBits = 0;
-    memset(ring_buff, ' ', sizeof(ring_buff));
-
     freq[T] = 0xffff;
     parent[R] = 0;
-
-    r = N - F;
 }
 
 // Rebuilt the tree
-void RebuildTree()
+void Decoder::RebuildTree()
 {
     unsigned i, j, k, f, l;
 
@@ -470,7 +481,7 @@ void RebuildTree()
 
 
 // Increment frequency of given code by one, and update tree
-void UpdateTree(int c)
+void Decoder::UpdateTree(int c)
 {
     unsigned i, j, k, l;
 
@@ -509,113 +520,113 @@ void UpdateTree(int c)
     } while ((c = parent[c]) != 0);  // Repeat up to root
 }
 
-inline unsigned GetChar()
+// Top up the bit buffer, with zeros beyond the end of the input
+inline void Decoder::Refill()
 {
-    uint8_t b;
-    return pfile->read(&b, sizeof(b)) ? b : 0;
-}
-
-// Get one bit
-unsigned GetBit()
-{
-    if (!uBits--)
+    while (m_bits <= 56)
     {
-        uBitBuff |= GetChar() << 8;
-        uBits = 7;
+        uint64_t b = (m_pb < m_end) ? *m_pb++ : 0;
+        m_bit_buff |= b << (56 - m_bits);
+        m_bits += 8;
     }
-
-    uBitBuff <<= 1;
-    return (uBitBuff >> 16) & 1;
 }
 
-// Get one byte
-unsigned GetByte()
+// Get up to 16 bits, first bit in the msb
+inline unsigned Decoder::GetBits(int count)
 {
-    if (uBits < 8)
-        uBitBuff |= GetChar() << (8 - uBits);
-    else
-        uBits -= 8;
-
-    uBitBuff <<= 8;
-    return (uBitBuff >> 16) & 0xff;
+    if (m_bits < count)
+        Refill();
+
+    auto value = static_cast<unsigned>(m_bit_buff >> (64 - count));
+    m_bit_buff <<= count;
+    m_bits -= count;
+    m_bits_used += count;
+    return value;
 }
 
-unsigned DecodeChar()
+unsigned Decoder::DecodeChar()
 {
     unsigned c = son[R];
 
     // Travel from root to leaf, choosing the smaller child node (son[]) if the
-    // read bit is 0, the bigger (son[]+1} if 1
+    // read bit is 0, the bigger (son[]+1} if 1. The path is taken straight from
+    // the bit buffer, which holds more bits than the deepest possible tree.
+    Refill();
+    auto bits = m_bit_buff;
+    auto count = 0;
+
     while (c < T)
-        c = son[c + GetBit()];
+    {
+        c = son[c + static_cast<unsigned>(bits >> 63)];
+        bits <<= 1;
+        ++count;
+    }
+
+    m_bit_buff = bits;
+    m_bits -= count;
+    m_bits_used += count;
 
     c -= T;
     UpdateTree(c);
     return c;
 }
 
-unsigned DecodePosition()
+unsigned Decoder::DecodePosition()
 {
-    unsigned i, j, c;
-
-    // Recover upper 6 bits from table
-    i = GetByte();
-    c = d_code[i] << 6;
-    j = d_len[i >> 4];
-
-    // Read lower 6 bits verbatim
-    for (j -= 2; j--; i = (i << 1) | GetBit());
+    // Recover upper 6 bits from table, then read lower 6 bits verbatim
+    auto i = GetBits(8);
+    auto c = d_code[i] << 6;
+    auto j = d_len[i >> 4] - 2;
 
+    i = (i << j) | GetBits(j);
     return c | (i & 0x3f);
 }
 
 
-// Unpack a given block into the supplied output buffer
-int Unpack(MemFile& file, uint8_t* pOut_)
+// Unpack the remaining input
+Data Decoder::Unpack()
 {
-    unsigned i, j, c;
-    auto uCount = 0;
-
-    // Store the input start/end positions and prepare to unpack
-    pfile = &file;
-    Init();
-
-    // Loop until we've processed all the input
-    while (!file.eof())
+    // Matches are copied from the output itself, which holds everything the
+    // ring buffer would. Anything before the start reads as the initial spaces.
+    Data out(std::max(static_cast<size_t>(m_end - m_pb) * 4, static_cast<size_t>(F)));
+    size_t len = 0;
+
+    // Loop until we've processed all the input. As with a byte-at-a-time
+    // reader, the input ends once the bits consumed reach the final byte.
+    auto total_bits = static_cast<uint64_t>(m_end - m_pb) * 8;
+    while (m_bits_used + 7 < total_bits)
     {
-        c = DecodeChar();
+        if (out.size() - len < F)
+            out.resize(out.size() * 2);
+
+        auto pb = out.data();
+        auto c = DecodeChar();
 
         // Single output character?
         if (c < 256)
-        {
-            *pOut_++ = c;
-            uCount++;
-
-            // Update the ring buffer and position (wrapping if necessary)
-            ring_buff[r++] = c;
-            r &= (N - 1);
-        }
+            pb[len++] = static_cast<uint8_t>(c);
         else
         {
-            // Position in ring buffer and length
-            i = (r - DecodePosition() - 1) & (N - 1);
-            j = c - 255 + THRESHOLD;
-
-            // Output the block
-            for (unsigned k = 0; k < j; ++k)
-            {
-                c = ring_buff[(i + k) & (N - 1)];
-                *pOut_++ = c;
-                uCount++;
+            // Match distance and length
+            size_t dist = DecodePosition() + 1;
+            auto count = c - 255 + THRESHOLD;
 
-                ring_buff[r++] = c;
-                r &= (N - 1);
-            }
+            // Output the block, which may overlap itself
+            for (unsigned k = 0; k < count; ++k, ++len)
+                pb[len] = (len >= dist) ? pb[len - dist] : ' ';
         }
     }
 
-    // Return the unpacked size
-    return uCount;
+    out.resize(len);
+    return out;
+}
+
+
+// Unpack the rest of the file
+Data Unpack(MemFile& file)
+{
+    Decoder decoder(file.ptr<uint8_t>(), file.remaining());
+    return decoder.Unpack();
 }
 
 } // namespace LZSS
@@ -25,20 +25,30 @@ struct UDI_TRACK
     uint8_t length[2];      // raw track size in bytes (usually 6250 bytes)
 };
 
+// The reference UDI code shifts a signed value, giving a CRC-32 variant
+// that differs from the standard one used by CRC32. The update is still
+// linear, so the low byte is covered by a table, and the rest of the value
+// is simply shifted down with its sign.
 static uint32_t crc32(const uint8_t* buf, int len)
 {
+    static std::array<int32_t, 256> crc_table;
+    static std::once_flag flag;
+
+    std::call_once(flag, [] {
+        for (int32_t i = 0; i < static_cast<int32_t>(crc_table.size()); ++i)
+        {
+            auto entry = i;
+            for (int j = 0; j < 8; ++j)
+                entry = (entry & 1) ? static_cast<int32_t>((entry >> 1) ^ 0xedb88320) : (entry >> 1);
+            crc_table[i] = entry;
+        }
+        });
+
     int32_t crc = ~0;
     for (int i = 0; i < len; i++)
     {
         crc ^= ~buf[i];
-        for (int j = 0; j < 8; ++j)
-        {
-            if (crc & 1)
-                crc = (crc >> 1) ^ 0xedb88320;
-            else
-                crc = (crc >> 1);
-        }
-        crc = ~crc;
+        crc = ~((crc >> 8) ^ crc_table[crc & 0xff]);
     }
 
     return static_cast<uint32_t>(crc);
@@ -68,7 +78,7 @@ bool ReadUDI(MemFile& file, std::shared_ptr<Disk>& disk)
     else if (file.seek(file_size) && file.read(&crc_buf, sizeof(crc_buf)))
     {
         auto crc_file = util::le_value(crc_buf);
-        auto crc = crc32(file.data().data(), file.size() - 4);
+        auto crc = crc32(file.bytes(), file.size() - 4);
         if (crc != crc_file)
             Message(msgWarning, "invalid file CRC");
         file.seek(sizeof(uh));
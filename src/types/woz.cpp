@@ -53,20 +53,6 @@ constexpr uint32_t id_value(const char* str)
         str[3];
 }
 
-static uint32_t crc32(const uint8_t* buf, size_t len)
-{
-    uint32_t crc = ~0U;
-
-    while (len-- > 0)
-    {
-        crc ^= *buf++;
-        for (int j = 0; j < 8; ++j)
-            crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
-    }
-
-    return ~crc;
-}
-
 bool ReadWOZ(MemFile& file, std::shared_ptr<Disk>& disk)
 {
     WOZ_HEADER wh;
@@ -76,7 +62,7 @@ bool ReadWOZ(MemFile& file, std::shared_ptr<Disk>& disk)
         return false;
 
     auto crc = util::le_value(wh.crc32);
-    if (crc && crc32(file.ptr<uint8_t>(), file.size() - file.tell()) != crc)
+    if (crc && CRC32(file.ptr<uint8_t>(), file.size() - file.tell()) != crc)
         Message(msgWarning, "file checksum is incorrect!");
 
     INFO_CHUNK info{};
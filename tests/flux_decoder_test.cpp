@@ -0,0 +1,156 @@
+// Check the batched FluxDecoder::decode() matches a next_bit() loop, for
+// the DEFAULT/MAX PLL settings and their lower limits.
+//
+// Synthetic flux is always tested, followed by the flux in any recorded
+// KryoFlux .raw stream files given on the command line.
+
+#include "SAMdisk.h"
+#include "FluxDecoder.h"
+#include "KryoFlux.h"
+
+OPTIONS opt;
+
+static const int pll_adjusts[] = { 1, DEFAULT_PLL_ADJUST, MAX_PLL_ADJUST };
+static const int pll_phases[] = { 1, DEFAULT_PLL_PHASE, MAX_PLL_PHASE };
+static const int flux_scales[] = { 100, 110 };
+
+// Bits, and the bit positions of index and sync loss events.
+struct DecodedBits
+{
+    std::vector<uint8_t> data{};
+    int bitsize = 0;
+    std::vector<int> indexes{};
+    std::vector<int> sync_losses{};
+};
+
+// Decode a bit at a time, recording events as BitBuffer used to.
+static DecodedBits decode_bits(FluxDecoder& decoder)
+{
+    DecodedBits bits;
+
+    for (;;)
+    {
+        auto bit = decoder.next_bit();
+        if (bit < 0)
+            break;
+
+        if (decoder.sync_lost())
+            bits.sync_losses.push_back(bits.bitsize);
+
+        if (bits.bitsize / 8 >= static_cast<int>(bits.data.size()))
+            bits.data.resize(bits.data.size() * 2 + 1);
+        if (bit)
+            bits.data[bits.bitsize / 8] |= 1 << (bits.bitsize & 7);
+        ++bits.bitsize;
+
+        if (decoder.index())
+            bits.indexes.push_back(bits.bitsize);
+    }
+
+    bits.data.resize((bits.bitsize + 7) / 8);
+    return bits;
+}
+
+static DecodedBits decode_batched(FluxDecoder& decoder)
+{
+    DecodedBits bits;
+    decoder.decode(bits.data, bits.bitsize, bits.indexes, bits.sync_losses);
+    bits.data.resize((bits.bitsize + 7) / 8);
+    return bits;
+}
+
+static bool compare(const std::string& name, const CompactFlux& flux_revs, int bitcell_ns)
+{
+    for (auto pll_adjust : pll_adjusts)
+    {
+        for (auto pll_phase : pll_phases)
+        {
+            for (auto flux_scale : flux_scales)
+            {
+                opt.pllphase = pll_phase;
+                FluxDecoder decoder1(flux_revs, bitcell_ns, flux_scale, pll_adjust);
+                FluxDecoder decoder2(flux_revs, bitcell_ns, flux_scale, pll_adjust);
+
+                auto bits1 = decode_bits(decoder1);
+                auto bits2 = decode_batched(decoder2);
+
+                if (bits1.bitsize != bits2.bitsize || bits1.data != bits2.data ||
+                    bits1.indexes != bits2.indexes || bits1.sync_losses != bits2.sync_losses)
+                {
+                    std::printf("%s: mismatch with bitcell=%d adjust=%d phase=%d scale=%d\n",
+                        name.c_str(), bitcell_ns, pll_adjust, pll_phase, flux_scale);
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static FluxData synthetic_flux(uint32_t seed, int bitcell_ns)
+{
+    auto rand = [&] { return (seed = seed * 1103515245 + 12345) >> 16; };
+    FluxData flux_revs(1 + rand() % 4);
+
+    // MFM-like intervals of 2-4 bitcells with jitter, plus the odd long gap
+    // and empty revolution to exercise sync loss and revolution changes.
+    for (auto& flux_times : flux_revs)
+    {
+        auto count = (rand() % 10) ? rand() % 3000 : 0;
+        for (auto i = 0u; i < count; ++i)
+        {
+            auto time_ns = bitcell_ns * (2 + rand() % 3) + static_cast<int>(rand() % 900) - 450;
+            flux_times.push_back((rand() % 50) ? time_ns : rand() % 20000);
+        }
+    }
+
+    if (flux_revs[0].empty())
+        flux_revs[0].push_back(bitcell_ns * 2);
+
+    return flux_revs;
+}
+
+int main(int argc, char* argv[])
+{
+    auto failures = 0;
+
+    for (auto i = 0; i < 40; ++i)
+    {
+        for (auto bitcell_ns : { 1000, 2000 })
+        {
+            CompactFlux flux_revs(synthetic_flux(i + 1, bitcell_ns));
+            if (!compare(util::fmt("synthetic #%d", i), flux_revs, bitcell_ns))
+                ++failures;
+        }
+    }
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        try
+        {
+            MemFile file;
+            file.open(argv[i]);
+
+            std::vector<std::string> warnings;
+            CompactFlux flux_revs(KryoFlux::DecodeStream(file.bytes(), file.size(), warnings));
+            if (flux_revs.empty())
+                continue;
+
+            // 250Kbps and 500Kbps MFM.
+            for (auto bitcell_ns : { 2000, 1000 })
+            {
+                if (!compare(argv[i], flux_revs, bitcell_ns))
+                    ++failures;
+            }
+        }
+        catch (std::exception& e)
+        {
+            std::printf("%s: %s\n", argv[i], e.what());
+            ++failures;
+        }
+    }
+
+    std::printf("%d recorded stream%s checked, %d failed\n", argc - 1, (argc == 2) ? "" : "s", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+// Replay KryoFlux streams through KFStreamDecoder in small and odd-sized
+// slices, checking the result matches a whole-stream DecodeStream().
+//
+// A synthetic stream covering every block type is always tested, followed
+// by any recorded .raw stream files given on the command line.
+
+#include "SAMdisk.h"
+#include "KryoFlux.h"
+
+OPTIONS opt;
+
+constexpr uint8_t OOB = KryoFlux::OOB;
+
+static void add_oob(Data& stream, uint8_t subtype, const Data& data)
+{
+    stream.push_back(OOB);
+    stream.push_back(subtype);
+    stream.push_back(static_cast<uint8_t>(data.size()));
+    stream.push_back(static_cast<uint8_t>(data.size() >> 8));
+    stream.insert(stream.end(), data.begin(), data.end());
+}
+
+static void add_oob(Data& stream, uint8_t subtype, std::initializer_list<uint32_t> dwords)
+{
+    Data data;
+    for (auto dw : dwords)
+    {
+        for (auto i = 0; i < 4; ++i)
+            data.push_back(static_cast<uint8_t>(dw >> (i * 8)));
+    }
+    add_oob(stream, subtype, data);
+}
+
+static Data synthetic_stream()
+{
+    Data stream;
+    uint32_t stream_pos = 0;
+    uint32_t seed = 12345;
+    auto rand = [&] { return (seed = seed * 1103515245 + 12345) >> 16; };
+
+    std::string info = "name=KryoFlux DiskSystem, sck=24027428.5714285, ick=3003428.5714285625";
+    add_oob(stream, 0x04, Data(info.c_str(), info.c_str() + info.length() + 1));
+
+    // Start part way through a revolution, as real streams do.
+    for (; stream_pos < 100; ++stream_pos)
+        stream.push_back(0x50);
+
+    for (auto rev = 0; rev < 5; ++rev)
+    {
+        add_oob(stream, 0x02, { stream_pos, 0, rev * 1000u });
+
+        for (auto i = 0; i < 3000; ++i)
+        {
+            auto r = rand();
+            switch (r % 16)
+            {
+            case 0:     // Flux2
+                stream.push_back(static_cast<uint8_t>(r % 8));
+                stream.push_back(static_cast<uint8_t>(r >> 4));
+                stream_pos += 2;
+                break;
+
+            case 1:     // Ovl16, then Flux3
+                stream.push_back(0x0b);
+                stream.push_back(0x0c);
+                stream.push_back(static_cast<uint8_t>(r >> 8));
+                stream.push_back(static_cast<uint8_t>(r));
+                stream_pos += 4;
+                break;
+
+            case 2:     // Nop1-3
+            {
+                auto nop_len = 1 + (r >> 4) % 3;
+                for (auto j = 0u; j < nop_len; ++j)
+                    stream.push_back(static_cast<uint8_t>(j ? 0 : 0x07 + nop_len));
+                stream_pos += nop_len;
+                break;
+            }
+
+            case 3:     // StreamInfo
+                add_oob(stream, 0x01, { stream_pos, 0 });
+                break;
+
+            default:    // Flux1
+                stream.push_back(static_cast<uint8_t>(0x0e + r % (0x100 - 0x0e)));
+                stream_pos++;
+                break;
+            }
+        }
+    }
+
+    add_oob(stream, 0x03, { stream_pos, 0 });
+
+    // EOF has a fixed fake size, and no data.
+    stream.insert(stream.end(), { OOB, 0x0d, 0x0d, 0x0d });
+    return stream;
+}
+
+static bool replay(const std::string& name, const Data& stream, bool synthetic)
+{
+    std::vector<std::string> ref_warnings;
+    auto len = static_cast<int>(stream.size());
+    auto ref_revs = KryoFlux::DecodeStream(stream.data(), len, ref_warnings);
+
+    if (synthetic && ref_revs.size() != 4)
+    {
+        std::printf("%s: expected 4 revolutions, got %zu\n", name.c_str(), ref_revs.size());
+        return false;
+    }
+
+    for (auto slice : { 1, 2, 3, 7, 13, 64, 4093, 65537 })
+    {
+        KFStreamDecoder decoder;
+        FluxData flux_revs;
+        std::vector<uint32_t> flux_times;
+
+        for (auto offset = 0; offset < len; offset += slice)
+        {
+            decoder.add(stream.data() + offset, std::min(len - offset, slice));
+            while (decoder.next_rev(flux_times))
+                flux_revs.push_back(std::move(flux_times));
+        }
+
+        // Revolutions are complete once the index after them is seen,
+        // so only the final one may wait for the end of the stream.
+        auto early_revs = flux_revs.size();
+
+        std::vector<std::string> warnings;
+        for (auto& rev : decoder.finish(warnings))
+            flux_revs.push_back(std::move(rev));
+        if (flux_revs.empty())
+            warnings.push_back("no flux data");
+
+        if (flux_revs != ref_revs || warnings != ref_warnings)
+        {
+            std::printf("%s: mismatch with %d-byte slices\n", name.c_str(), slice);
+            return false;
+        }
+
+        if (synthetic && early_revs + 1 < flux_revs.size())
+        {
+            std::printf("%s: only %zu of %zu revolutions available early with %d-byte slices\n",
+                name.c_str(), early_revs, flux_revs.size(), slice);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    auto failures = 0;
+
+    if (!replay("synthetic", synthetic_stream(), true))
+        ++failures;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        try
+        {
+            MemFile file;
+            file.open(argv[i]);
+            if (!replay(argv[i], file.data(), false))
+                ++failures;
+        }
+        catch (std::exception& e)
+        {
+            std::printf("%s: %s\n", argv[i], e.what());
+            ++failures;
+        }
+    }
+
+    std::printf("%d stream%s replayed, %d failed\n", argc, (argc == 1) ? "" : "s", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}